@@ -1,47 +1,156 @@
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "tinyusb.h"
 #include "tinyusb_default_config.h"
 #include "tusb.h"
 #include "class/hid/hid_device.h"
+#include "alive_hid.h"
+#include "state_push.h"
+#include "hid_auth.h"
+#include "cmd_worker.h"
+#include "irq_queue.h"
+#include "hid_tx.h"
 
 #define REPORT_SIZE 64
 
 static const char *TAG = "R-SODIUM Controller";
 
 static TaskHandle_t hid_alive_handle = NULL;
+static volatile bool hid_alive_enabled = false;
+static volatile bool hid_alive_activity = false;
+
+#define HEARTBEAT_FAST_MS        500
+#define HEARTBEAT_IDLE_MS        10000
+#define HEARTBEAT_UNMOUNTED_MS   500
+#define MAX_IRQ_STAT_PINS        8
+
+static void put_u16(uint8_t *p, uint32_t v) {
+    uint16_t v16 = v > 0xFFFF ? 0xFFFF : v;
+    memcpy(p, &v16, 2);
+}
+
+// 心跳状态帧：0xFF, 类型, 版本, 供电轨电平, 运行时间(s), 已执行命令数, 中断事件数,
+// 合并边沿数(u16), 丢弃边沿数(u16), 上一条命令耗时(us), 命令队列溢出数(u16)，之后为 HMAC
+static void build_heartbeat(uint8_t *report) {
+    cmd_worker_stats_t cmd_stats;
+    irq_pin_stats_t pin_stats[MAX_IRQ_STAT_PINS];
+    uint32_t events = 0, coalesced = 0, dropped = 0;
+    uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    cmd_worker_get_stats(&cmd_stats);
+    int pin_count = irq_get_pin_stats(pin_stats, MAX_IRQ_STAT_PINS);
+    for (int i = 0; i < pin_count; i++) {
+        events += pin_stats[i].events;
+        coalesced += pin_stats[i].coalesced + pin_stats[i].filtered;
+        dropped += pin_stats[i].dropped;
+    }
+
+    memset(report, 0, REPORT_SIZE);
+    report[0] = 0xFF;
+    report[1] = HEARTBEAT_TYPE;
+    report[2] = HEARTBEAT_VERSION;
+    report[3] = state_push_rail_levels();
+    memcpy(report + 4, &uptime_s, 4);
+    memcpy(report + 8, &cmd_stats.processed, 4);
+    memcpy(report + 12, &events, 4);
+    put_u16(report + 16, coalesced);
+    put_u16(report + 18, dropped);
+    memcpy(report + 20, &cmd_stats.last_latency_us, 4);
+    put_u16(report + 24, cmd_stats.overflow);
+    hid_auth_sign(report, 32, report + 32);
+}
+
+static TickType_t ticks_until(TickType_t deadline, TickType_t now) {
+    int32_t diff = (int32_t)(deadline - now);
+    return diff > 0 ? (TickType_t)diff : 0;
+}
 
 void hid_alive_task(void *pvParameters) {
-    vTaskDelay(pdMS_TO_TICKS(8000));
+    uint32_t interval_ms = HEARTBEAT_FAST_MS;
+    // 不再固定等待 8 s：未枚举时不发送，挂载后由 hid_alive_wake() 立即唤醒
+    TickType_t next_beat = xTaskGetTickCount();
+    bool was_enabled = true;
+
     while (1) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+        if (hid_alive_enabled) {
+            wait = ticks_until(next_beat, now);
+            uint32_t push_wait_ms = state_push_wait_ms();
+            if (push_wait_ms != UINT32_MAX && pdMS_TO_TICKS(push_wait_ms) + 1 < wait) {
+                wait = pdMS_TO_TICKS(push_wait_ms) + 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        now = xTaskGetTickCount();
+        if (!hid_alive_enabled) {
+            was_enabled = false;
+            continue;
+        }
+        if (!was_enabled || hid_alive_activity) {
+            // 刚恢复或有状态变化：回到快速心跳
+            was_enabled = true;
+            hid_alive_activity = false;
+            interval_ms = HEARTBEAT_FAST_MS;
+            if (ticks_until(next_beat, now) > pdMS_TO_TICKS(interval_ms)) {
+                next_beat = now + pdMS_TO_TICKS(interval_ms);
+            }
+        }
         if (!tud_mounted()) {
-            vTaskDelay(pdMS_TO_TICKS(500));
+            next_beat = now + pdMS_TO_TICKS(HEARTBEAT_UNMOUNTED_MS);
             continue;
         }
+
         uint8_t report[REPORT_SIZE];
-        memset(report, 0xFF, REPORT_SIZE);
-        tud_hid_report(0, report, REPORT_SIZE);
-        ESP_LOGD(TAG, "Sent HID report filled with 0xFF");
-        vTaskDelay(pdMS_TO_TICKS(2000));
+        if (state_push_build(report)) {
+            // 推送报文复用心跳通道，同时算作一次心跳
+            hid_tx_send(report, HID_TX_PUSH);
+            interval_ms = HEARTBEAT_FAST_MS;
+            next_beat = now + pdMS_TO_TICKS(interval_ms);
+            ESP_LOGD(TAG, "Sent state push: rails 0x%02X changed 0x%02X", report[2], report[3]);
+        } else if (ticks_until(next_beat, now) == 0) {
+            build_heartbeat(report);
+            hid_tx_send(report, HID_TX_HEARTBEAT);
+            next_beat = now + pdMS_TO_TICKS(interval_ms);
+            // 无变化时心跳间隔逐次加倍，直到空闲间隔
+            interval_ms = interval_ms * 2 > HEARTBEAT_IDLE_MS ? HEARTBEAT_IDLE_MS : interval_ms * 2;
+            ESP_LOGD(TAG, "Sent heartbeat, next in %lu ms", (unsigned long)interval_ms);
+        }
+    }
+}
+
+void hid_alive_wake(void) {
+    hid_alive_activity = true;
+    TaskHandle_t handle = hid_alive_handle;
+    if (handle != NULL) {
+        xTaskNotifyGive(handle);
     }
 }
 
 void start_hid_alive_task() {
-    if (hid_alive_handle != NULL) {
-        ESP_LOGW(TAG, "hid_alive_task already running, skip create");
+    if (hid_alive_enabled) {
         return;
     }
-    ESP_LOGI(TAG,"Start hid alive task...");
-    xTaskCreate(hid_alive_task, "hid_alive_task", 4096, NULL, 5, &hid_alive_handle);
+    hid_alive_enabled = true;
+    if (hid_alive_handle == NULL) {
+        ESP_LOGI(TAG,"Start hid alive task...");
+        xTaskCreate(hid_alive_task, "hid_alive_task", 3072, NULL, 5, &hid_alive_handle);
+    } else {
+        ESP_LOGI(TAG,"Resume hid alive task...");
+        xTaskNotifyGive(hid_alive_handle);
+    }
 }
 
 void stop_hid_alive_task() {
-    if (hid_alive_handle != NULL) {
-        vTaskDelete(hid_alive_handle);
-        hid_alive_handle = NULL;
+    if (hid_alive_enabled) {
+        hid_alive_enabled = false;
+        xTaskNotifyGive(hid_alive_handle);
         ESP_LOGI(TAG,"Stop hid alive task...");
     }
 }
\ No newline at end of file
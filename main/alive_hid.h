@@ -3,8 +3,12 @@
 
 #include <stdint.h>
 
+#define HEARTBEAT_TYPE    0x02
+#define HEARTBEAT_VERSION 0x01
+
 void hid_alive_task(void *pvParameters);
 void start_hid_alive_task();
 void stop_hid_alive_task();
+void hid_alive_wake(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "boot_prof.h"
+
+static const char *TAG = "Boot Profiler";
+
+#define BOOT_PROF_MAGIC 0x42505246   // "BPRF"
+
+// 放在 RTC 内存中，软件复位 / DFU 返回后仍可读取上一次启动的各阶段时间
+typedef struct {
+    uint32_t magic;
+    uint32_t boot_count;
+    uint32_t current[BOOT_PHASE_COUNT];
+    uint32_t previous[BOOT_PHASE_COUNT];
+} boot_prof_t;
+
+static RTC_NOINIT_ATTR boot_prof_t boot_prof;
+
+void boot_prof_init(void) {
+    if (boot_prof.magic != BOOT_PROF_MAGIC) {
+        // 上电复位后 RTC 内存内容随机
+        memset(&boot_prof, 0, sizeof(boot_prof));
+        boot_prof.magic = BOOT_PROF_MAGIC;
+    } else {
+        memcpy(boot_prof.previous, boot_prof.current, sizeof(boot_prof.previous));
+        memset(boot_prof.current, 0, sizeof(boot_prof.current));
+    }
+    boot_prof.boot_count++;
+    boot_prof_mark(BOOT_PHASE_APP_MAIN);
+}
+
+// 只记录每次启动中第一次到达该阶段的时间，0 表示尚未到达
+void boot_prof_mark(boot_phase_t phase) {
+    if (phase >= BOOT_PHASE_COUNT || boot_prof.current[phase] != 0) {
+        return;
+    }
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    boot_prof.current[phase] = now_us ? now_us : 1;
+    ESP_LOGI(TAG, "Phase %d at %lu us", phase, (unsigned long)now_us);
+}
+
+uint32_t boot_prof_boot_count(void) {
+    return boot_prof.boot_count;
+}
+
+bool boot_prof_get(bool previous, boot_phase_t phase, uint32_t *us) {
+    if (phase >= BOOT_PHASE_COUNT) {
+        return false;
+    }
+    *us = previous ? boot_prof.previous[phase] : boot_prof.current[phase];
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef BOOT_PROF_H
+#define BOOT_PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    BOOT_PHASE_APP_MAIN = 0,    // 进入 app_main
+    BOOT_PHASE_CRYPTO,          // PSA / HMAC 密钥就绪
+    BOOT_PHASE_NVS,             // 配置镜像加载完成
+    BOOT_PHASE_GPIO,            // GPIO 与上电时序初始化完成
+    BOOT_PHASE_RESTORE,         // restore_state() 完成
+    BOOT_PHASE_USB_INSTALL,     // TinyUSB 驱动安装完成
+    BOOT_PHASE_USB_CONNECT,     // 重新拉起 D+，开始枚举
+    BOOT_PHASE_USB_RESET,       // 收到第一次总线复位
+    BOOT_PHASE_USB_MOUNTED,     // 主机完成枚举
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+void boot_prof_init(void);
+void boot_prof_mark(boot_phase_t phase);
+uint32_t boot_prof_boot_count(void);
+bool boot_prof_get(bool previous, boot_phase_t phase, uint32_t *us);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "cmd_table.h"
+#include "gpio_handle.h"
+#include "hid_ota.h"
+
+#define READABLE_GPIO_MASK (SWITCH_GPIO_MASK | HDDPC_GPIO_MASK | PWR_GPIO_MASK | IO_GPIO_MASK)
+#define IRQ_GPIO_MASK      (HDDPC_GPIO_MASK | PWR_GPIO_MASK | (1ULL << GPIO_NUM_34) | (1ULL << GPIO_NUM_38))
+
+// 按操作码(data[0])索引，处理函数实现在 process_commander.c
+static const cmd_spec_t cmd_specs[256] = {
+    [0x00] = { SWITCH_GPIO_MASK,   5,                  CMD_FLAG_NVS_WRITE, cmd_gpio_set },
+    [0x01] = { SWITCH_GPIO_MASK,   5,                  CMD_FLAG_NVS_WRITE, cmd_gpio_set },
+    [0x02] = { SWITCH_GPIO_MASK,   1,                  0,                  cmd_gpio_saved },
+    [0x03] = { READABLE_GPIO_MASK, 1,                  0,                  cmd_gpio_live },
+    [0x04] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_enclosure_get },
+    [0x05] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_enclosure_set },
+    [0x06] = { SWITCH_GPIO_MASK,   4,                  CMD_FLAG_NVS_WRITE, cmd_ext_gpio_set },
+    [0x07] = { SWITCH_GPIO_MASK,   1,                  0,                  cmd_ext_gpio_get },
+    [0x08] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_onpower_set },
+    [0x09] = { 0,                  1,                  0,                  cmd_onpower_get },
+    [0x0A] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_susp_set },
+    [0x0B] = { 0,                  1,                  0,                  cmd_susp_get },
+    [0x0C] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_ususp_set },
+    [0x0D] = { 0,                  1,                  0,                  cmd_ususp_get },
+    [0x0F] = { 0,                  1,                  0,                  cmd_power_summary },
+    [0x10] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_ext_restart_set },
+    [0x11] = { 0,                  1,                  0,                  cmd_worker_stats },
+    [0x12] = { 0,                  1,                  0,                  cmd_power_seq_status },
+    [0x13] = { 0,                  7,                  CMD_FLAG_NVS_WRITE, cmd_policy_set },
+    [0x14] = { 0,                  1,                  0,                  cmd_policy_get },
+    [0x15] = { IRQ_GPIO_MASK,      2,                  CMD_FLAG_NVS_WRITE, cmd_debounce_set },
+    [0x16] = { 0,                  2,                  0,                  cmd_irq_stats },
+    [0x17] = { 0,                  4,                  0,                  cmd_push_subscribe },
+    [0x18] = { 0,                  5,                  0,                  cmd_event_log_read },
+    [0x19] = { 0,                  1,                  0,                  cmd_opcode_stats },
+    [0x1A] = { 0,                  1,                  0,                  cmd_snapshot },
+    [0x1B] = { 0,                  7,                  CMD_FLAG_NVS_WRITE, cmd_gpio_batch },
+    [0x1C] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_nvs_flush },
+    [0x1D] = { 0,                  16,                 0,                  cmd_nvs_wear },
+    [0x1E] = { 0,                  2,                  0,                  cmd_boot_profile },
+    [0x1F] = { 0,                  1,                  0,                  cmd_usb_health },
+    [0x20] = { 0,                  1,                  0,                  cmd_latency_hist },
+    [0x21] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_hid_profile },
+    [0x22] = { 0,                  1,                  0,                  cmd_hid_tx_stats },
+    [0x23] = { 0,                  1,                  0,                  cmd_proto_window },
+    [0x24] = { 0,                  5,                  0,                  cmd_ota_begin },
+    [0x25] = { 0,                  17,                 0,                  cmd_ota_hash },
+    [0x26] = { 0,                  5 + OTA_CHUNK_MAX,  0,                  cmd_ota_data },
+    [0x27] = { 0,                  1,                  CMD_FLAG_NVS_WRITE, cmd_ota_commit },
+    [0x28] = { 0,                  1,                  0,                  cmd_ota_status },
+    [0x29] = { 0,                  1,                  0,                  cmd_vendor_stats },
+    [0x2A] = { 0,                  1,                  0,                  cmd_rail_latency },
+    [0xFA] = { 0,                  1,                  0,                  cmd_version },
+    [0xFB] = { 0,                  1,                  0,                  cmd_dfu },
+    [0xFC] = { 0,                  1,                  0,                  cmd_reset },
+    [0xFD] = { 0,                  1,                  0,                  cmd_apply_all },
+};
+
+const cmd_spec_t *command_lookup(uint8_t opcode) {
+    return cmd_specs[opcode].payload_len != 0 ? &cmd_specs[opcode] : NULL;
+}
+
+// data_len 为帧中经过 HMAC 覆盖的 data 字节数(v1 为 31，v2 为 29)
+cmd_check_t command_validate(uint8_t opcode, uint8_t cmd, size_t data_len) {
+    const cmd_spec_t *spec = command_lookup(opcode);
+    if (spec == NULL) {
+        return CMD_CHECK_UNKNOWN;
+    }
+    if (spec->gpio_mask != 0 && (cmd >= 64 || !(spec->gpio_mask & (1ULL << cmd)))) {
+        return CMD_CHECK_BAD_GPIO;
+    }
+    if (spec->payload_len > data_len) {
+        return CMD_CHECK_BAD_LENGTH;
+    }
+    return CMD_CHECK_OK;
+}
\ No newline at end of file
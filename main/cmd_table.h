@@ -0,0 +1,76 @@
+#ifndef CMD_TABLE_H
+#define CMD_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CMD_FLAG_NVS_WRITE 0x01
+
+typedef void (*cmd_handler_t)(uint8_t cmd, const uint8_t *data);
+
+// 操作码的参数约束与处理函数；表本身不依赖 ESP-IDF，主机测试中处理函数由 test/host 下的桩实现
+typedef struct {
+    uint64_t gpio_mask;     // 非 0 时 cmd 字节为 GPIO 编号，必须落在掩码内
+    uint8_t payload_len;    // 命令使用的 data 字节数(含操作码)，0 表示未定义的操作码
+    uint8_t flags;
+    cmd_handler_t handler;
+} cmd_spec_t;
+
+typedef enum {
+    CMD_CHECK_OK = 0,
+    CMD_CHECK_UNKNOWN,
+    CMD_CHECK_BAD_GPIO,
+    CMD_CHECK_BAD_LENGTH,
+} cmd_check_t;
+
+// 处理函数，定义在 process_commander.c
+void cmd_gpio_set(uint8_t cmd, const uint8_t *data);
+void cmd_gpio_saved(uint8_t cmd, const uint8_t *data);
+void cmd_gpio_live(uint8_t cmd, const uint8_t *data);
+void cmd_enclosure_get(uint8_t cmd, const uint8_t *data);
+void cmd_enclosure_set(uint8_t cmd, const uint8_t *data);
+void cmd_ext_gpio_set(uint8_t cmd, const uint8_t *data);
+void cmd_ext_gpio_get(uint8_t cmd, const uint8_t *data);
+void cmd_onpower_set(uint8_t cmd, const uint8_t *data);
+void cmd_onpower_get(uint8_t cmd, const uint8_t *data);
+void cmd_susp_set(uint8_t cmd, const uint8_t *data);
+void cmd_susp_get(uint8_t cmd, const uint8_t *data);
+void cmd_ususp_set(uint8_t cmd, const uint8_t *data);
+void cmd_ususp_get(uint8_t cmd, const uint8_t *data);
+void cmd_power_summary(uint8_t cmd, const uint8_t *data);
+void cmd_ext_restart_set(uint8_t cmd, const uint8_t *data);
+void cmd_worker_stats(uint8_t cmd, const uint8_t *data);
+void cmd_power_seq_status(uint8_t cmd, const uint8_t *data);
+void cmd_policy_set(uint8_t cmd, const uint8_t *data);
+void cmd_policy_get(uint8_t cmd, const uint8_t *data);
+void cmd_debounce_set(uint8_t cmd, const uint8_t *data);
+void cmd_irq_stats(uint8_t cmd, const uint8_t *data);
+void cmd_push_subscribe(uint8_t cmd, const uint8_t *data);
+void cmd_event_log_read(uint8_t cmd, const uint8_t *data);
+void cmd_opcode_stats(uint8_t cmd, const uint8_t *data);
+void cmd_snapshot(uint8_t cmd, const uint8_t *data);
+void cmd_gpio_batch(uint8_t cmd, const uint8_t *data);
+void cmd_nvs_flush(uint8_t cmd, const uint8_t *data);
+void cmd_nvs_wear(uint8_t cmd, const uint8_t *data);
+void cmd_boot_profile(uint8_t cmd, const uint8_t *data);
+void cmd_usb_health(uint8_t cmd, const uint8_t *data);
+void cmd_latency_hist(uint8_t cmd, const uint8_t *data);
+void cmd_hid_profile(uint8_t cmd, const uint8_t *data);
+void cmd_hid_tx_stats(uint8_t cmd, const uint8_t *data);
+void cmd_proto_window(uint8_t cmd, const uint8_t *data);
+void cmd_ota_begin(uint8_t cmd, const uint8_t *data);
+void cmd_ota_hash(uint8_t cmd, const uint8_t *data);
+void cmd_ota_data(uint8_t cmd, const uint8_t *data);
+void cmd_ota_commit(uint8_t cmd, const uint8_t *data);
+void cmd_ota_status(uint8_t cmd, const uint8_t *data);
+void cmd_vendor_stats(uint8_t cmd, const uint8_t *data);
+void cmd_rail_latency(uint8_t cmd, const uint8_t *data);
+void cmd_version(uint8_t cmd, const uint8_t *data);
+void cmd_dfu(uint8_t cmd, const uint8_t *data);
+void cmd_reset(uint8_t cmd, const uint8_t *data);
+void cmd_apply_all(uint8_t cmd, const uint8_t *data);
+
+const cmd_spec_t *command_lookup(uint8_t opcode);
+cmd_check_t command_validate(uint8_t opcode, uint8_t cmd, size_t data_len);
+
+#endif
\ No newline at end of file
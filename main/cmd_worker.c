@@ -0,0 +1,190 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cmd_worker.h"
+#include "hid_auth.h"
+#include "process_commander.h"
+#include "alive_hid.h"
+#include "state_push.h"
+
+static const char *TAG = "CMD Worker";
+#define REPORT_SIZE      64
+#define SAMPLE_TAG_LEN    4         // 用回复 MAC 的前 4 字节识别被采样的回复
+#define SAMPLE_TIMEOUT_US 1000000   // 超过 1 s 未送达的采样视为回复已丢失
+
+typedef struct {
+    uint8_t data[REPORT_SIZE];
+    int64_t rx_us;
+} cmd_report_t;
+
+static QueueHandle_t cmd_queue = NULL;
+static cmd_worker_stats_t worker_stats;
+static latency_hist_t latency[LATENCY_KIND_COUNT];
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t inflight_window = CMD_QUEUE_DEPTH;
+static volatile uint32_t in_flight = 0;   // 已入队或正在执行的命令数
+static portMUX_TYPE in_flight_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t worker_task_handle = NULL;
+static int64_t current_rx_us = 0;            // 正在执行且尚未发出回复的命令的接收时间，只在 cmd_worker 任务中读写
+static int64_t pending_rx_us = 0;            // 被采样回复对应命令的接收时间，0 表示无
+static uint8_t pending_tag[SAMPLE_TAG_LEN];
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void in_flight_done(void) {
+    portENTER_CRITICAL(&in_flight_lock);
+    in_flight--;
+    portEXIT_CRITICAL(&in_flight_lock);
+}
+
+static void latency_record(latency_kind_t kind, uint32_t us) {
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && us >= ((uint32_t)LATENCY_BUCKET0_US << bucket)) {
+        bucket++;
+    }
+    portENTER_CRITICAL(&latency_lock);
+    latency[kind].buckets[bucket]++;
+    latency[kind].count++;
+    if (us > latency[kind].max_us) {
+        latency[kind].max_us = us;
+    }
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+static void cmd_worker_task(void *param) {
+    cmd_report_t report;
+    for (;;) {
+        if (xQueueReceive(cmd_queue, &report, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        // 首字节为 0xFD 且通过 v2 MAC 校验才是 v2 帧，否则按 v1 校验
+        bool v2 = report.data[0] == PROTO_V2_MARKER && hid_auth_verify_v2(report.data, 32, report.data + 32);
+        if (!v2 && !hid_auth_verify(report.data, 32, report.data + 32)) {
+            worker_stats.auth_fail++;
+            in_flight_done();
+            ESP_LOGW(TAG, "HMAC mismatch");
+            continue;
+        }
+        ESP_LOGD(TAG, "Received command: 0x%02X", report.data[0]);
+        if (!state_push_subscribed()) {
+            stop_hid_alive_task();
+        }
+        current_rx_us = report.rx_us;
+        if (v2) {
+            process_command_tagged(report.data[1], report.data[2], report.data + PROTO_V2_HEADER);
+        } else {
+            process_command(report.data[0], report.data + 1);
+        }
+        current_rx_us = 0;
+        in_flight_done();
+        worker_stats.processed++;
+        worker_stats.last_latency_us = (uint32_t)(esp_timer_get_time() - report.rx_us);
+        latency_record(LATENCY_PROCESS, worker_stats.last_latency_us);
+    }
+}
+
+void cmd_worker_start(void) {
+    cmd_queue = xQueueCreate(CMD_QUEUE_DEPTH, sizeof(cmd_report_t));
+    xTaskCreate(cmd_worker_task, "cmd_worker", 4096, NULL, 4, &worker_task_handle);
+}
+
+// 在 TinyUSB 回调中调用：只做拷贝入队，验证与执行交给 cmd_worker_task
+void cmd_worker_submit(const uint8_t *report, uint16_t len) {
+    int64_t start = esp_timer_get_time();
+
+    if (len != REPORT_SIZE) {
+        ESP_LOGW(TAG, "Invalid report size");
+        return;
+    }
+    worker_stats.received++;
+    cmd_report_t item;
+    memcpy(item.data, report, REPORT_SIZE);
+    item.rx_us = start;
+    // 在途命令达到窗口或队列已满：立即回复 BUSY，主机应稍后重发
+    bool accepted = false;
+    portENTER_CRITICAL(&in_flight_lock);
+    if (in_flight < inflight_window) {
+        in_flight++;
+        accepted = true;
+    }
+    portEXIT_CRITICAL(&in_flight_lock);
+    if (accepted && xQueueSend(cmd_queue, &item, 0) != pdTRUE) {
+        in_flight_done();
+        accepted = false;
+    }
+    if (!accepted) {
+        worker_stats.overflow++;
+        // 只有首字节为 0xFD 时才需要校验 MAC 来选择回复格式
+        if (report[0] == PROTO_V2_MARKER && hid_auth_verify_v2(report, 32, report + 32)) {
+            send_hid_reply_tagged(report[1], report[3], (const uint8_t *)"BUSY", 4);
+        } else {
+            send_hid_reply_tagged(PROTO_NO_TAG, report[1], (const uint8_t *)"BUSY", 4);
+        }
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsed > worker_stats.cb_max_us) {
+        worker_stats.cb_max_us = elapsed;
+    }
+}
+
+void cmd_worker_get_stats(cmd_worker_stats_t *stats) {
+    *stats = worker_stats;
+}
+
+// send_hid_reply_tagged() 签名后、入队前调用：cmd_worker 任务中当前命令的第一条回复作为端到端采样，
+// 其他任务发出的回复(如 BUSY)不采样。流水线时只采样最早一条尚未送达的回复
+void cmd_worker_note_reply(const uint8_t *report) {
+    if (xTaskGetCurrentTaskHandle() != worker_task_handle || current_rx_us == 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&pending_lock);
+    if (pending_rx_us == 0 || now - pending_rx_us > SAMPLE_TIMEOUT_US) {
+        pending_rx_us = current_rx_us;
+        memcpy(pending_tag, report + 32, SAMPLE_TAG_LEN);
+    }
+    portEXIT_CRITICAL(&pending_lock);
+    current_rx_us = 0;
+}
+
+// tud_hid_report_complete_cb 中调用：只有被采样的那条回复送达时才记录端到端延迟
+void cmd_worker_report_complete(const uint8_t *report) {
+    int64_t rx_us = 0;
+    portENTER_CRITICAL(&pending_lock);
+    if (pending_rx_us != 0 && memcmp(report + 32, pending_tag, SAMPLE_TAG_LEN) == 0) {
+        rx_us = pending_rx_us;
+        pending_rx_us = 0;
+    }
+    portEXIT_CRITICAL(&pending_lock);
+    if (rx_us != 0) {
+        latency_record(LATENCY_END_TO_END, (uint32_t)(esp_timer_get_time() - rx_us));
+    }
+}
+
+void cmd_worker_get_latency(latency_kind_t kind, latency_hist_t *out) {
+    portENTER_CRITICAL(&latency_lock);
+    *out = latency[kind];
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+void cmd_worker_reset_latency(void) {
+    portENTER_CRITICAL(&latency_lock);
+    memset(latency, 0, sizeof(latency));
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+// 主机可把窗口调小以保证不会收到 BUSY；范围 1..CMD_QUEUE_DEPTH
+void cmd_worker_set_window(uint8_t window) {
+    inflight_window = (window == 0 || window > CMD_QUEUE_DEPTH) ? CMD_QUEUE_DEPTH : window;
+}
+
+uint8_t cmd_worker_get_window(void) {
+    return inflight_window;
+}
+
+uint32_t cmd_worker_in_flight(void) {
+    return in_flight;
+}
\ No newline at end of file
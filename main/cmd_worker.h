@@ -0,0 +1,44 @@
+#ifndef CMD_WORKER_H
+#define CMD_WORKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CMD_QUEUE_DEPTH  8
+
+typedef struct {
+    uint32_t received;
+    uint32_t processed;
+    uint32_t overflow;
+    uint32_t auth_fail;
+    uint32_t cb_max_us;
+    uint32_t last_latency_us;
+} cmd_worker_stats_t;
+
+#define LATENCY_BUCKETS      12
+#define LATENCY_BUCKET0_US   128   // 第 i 桶上限为 128us << i，最后一桶不设上限
+
+typedef enum {
+    LATENCY_PROCESS = 0,   // OUT 报告到 process_command() 返回（回复已入队）
+    LATENCY_END_TO_END,    // OUT 报告到回复的 IN 传输完成
+    LATENCY_KIND_COUNT
+} latency_kind_t;
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_t;
+
+void cmd_worker_start(void);
+void cmd_worker_submit(const uint8_t *report, uint16_t len);
+void cmd_worker_get_stats(cmd_worker_stats_t *stats);
+void cmd_worker_note_reply(const uint8_t *report);
+void cmd_worker_report_complete(const uint8_t *report);
+void cmd_worker_set_window(uint8_t window);
+uint8_t cmd_worker_get_window(void);
+uint32_t cmd_worker_in_flight(void);
+void cmd_worker_get_latency(latency_kind_t kind, latency_hist_t *out);
+void cmd_worker_reset_latency(void);
+
+#endif
\ No newline at end of file
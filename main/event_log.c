@@ -0,0 +1,71 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "event_log.h"
+
+static const char *TAG = "Event Log";
+
+#define DRAIN_PERIOD_MS 1000
+
+static event_record_t event_ring[EVENT_LOG_SIZE];
+static uint32_t event_head = 0;   // 下一条记录的序号
+static portMUX_TYPE event_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void event_log_record(uint8_t type, uint8_t opcode, uint8_t a, uint8_t b) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&event_lock);
+    event_record_t *rec = &event_ring[event_head & (EVENT_LOG_SIZE - 1)];
+    rec->timestamp_us = now;
+    rec->type = type;
+    rec->opcode = opcode;
+    rec->a = a;
+    rec->b = b;
+    event_head++;
+    portEXIT_CRITICAL(&event_lock);
+}
+
+// 从序号 *from_seq 开始读取最多 max 条记录；过旧的序号会被调整到最早仍保留的记录
+int event_log_read(uint32_t *from_seq, event_record_t *out, int max) {
+    int count = 0;
+    portENTER_CRITICAL(&event_lock);
+    uint32_t oldest = event_head > EVENT_LOG_SIZE ? event_head - EVENT_LOG_SIZE : 0;
+    uint32_t seq = *from_seq;
+    if (seq < oldest || seq > event_head) {
+        seq = oldest;
+    }
+    *from_seq = seq;
+    while (count < max && seq + count != event_head) {
+        out[count] = event_ring[(seq + count) & (EVENT_LOG_SIZE - 1)];
+        count++;
+    }
+    portEXIT_CRITICAL(&event_lock);
+    return count;
+}
+
+// 低优先级任务，仅在 CPU 空闲时把新记录格式化输出到串口
+static void event_log_drain_task(void *param) {
+    uint32_t next_seq = 0;
+    event_record_t batch[8];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+        int count;
+        while ((count = event_log_read(&next_seq, batch, 8)) > 0) {
+            for (int i = 0; i < count; i++) {
+                const event_record_t *rec = &batch[i];
+                if (rec->type == EVT_COMMAND) {
+                    ESP_LOGI(TAG, "[%lu] cmd 0x%02X arg 0x%02X data1 0x%02X",
+                             (unsigned long)rec->timestamp_us, rec->opcode, rec->a, rec->b);
+                } else {
+                    ESP_LOGI(TAG, "[%lu] rsp 0x%02X first 0x%02X len %d",
+                             (unsigned long)rec->timestamp_us, rec->opcode, rec->a, rec->b);
+                }
+            }
+            next_seq += count;
+        }
+    }
+}
+
+void event_log_start_drain(void) {
+    xTaskCreate(event_log_drain_task, "event_log_drain", 2560, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
\ No newline at end of file
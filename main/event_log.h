@@ -0,0 +1,26 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+
+#define EVENT_LOG_SIZE 128   // 必须为 2 的幂
+
+typedef enum {
+    EVT_COMMAND = 0x01,   // a: cmd 字节, b: data[1]
+    EVT_RESPONSE = 0x02,  // a: 负载首字节, b: 负载长度
+    EVT_USB_RECOVERY = 0x03, // a: 恢复原因, b: 此前恢复次数
+} event_type_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    uint8_t type;
+    uint8_t opcode;
+    uint8_t a;
+    uint8_t b;
+} event_record_t;
+
+void event_log_record(uint8_t type, uint8_t opcode, uint8_t a, uint8_t b);
+int event_log_read(uint32_t *from_seq, event_record_t *out, int max);
+void event_log_start_drain(void);
+
+#endif
\ No newline at end of file
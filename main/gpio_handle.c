@@ -1,48 +1,33 @@
+#include <string.h>
 #include "driver/gpio.h"
 #include "gpio_handle.h"
-#include "nvs.h"
-#include "nvs_flash.h"
+#include "soc/gpio_reg.h"
 #include "esp_log.h"
 #include "nvs_handle.h"
-#include <unistd.h>
-
-#define SWITCH_GPIO_MASK ((1ULL << GPIO_NUM_14) | (1ULL << GPIO_NUM_21) | (1ULL << GPIO_NUM_33) | (1ULL << GPIO_NUM_34) | (1ULL << GPIO_NUM_35) | (1ULL << GPIO_NUM_36)  | (1ULL << GPIO_NUM_37)  | (1ULL << GPIO_NUM_38)  | (1ULL << GPIO_NUM_45))
-#define HDDPC_GPIO_MASK ((1ULL << GPIO_NUM_11) | (1ULL << GPIO_NUM_12) | (1ULL << GPIO_NUM_13))
-#define PWR_GPIO_MASK ((1ULL << GPIO_NUM_1))
-#define IO_GPIO_MASK ((1ULL << GPIO_NUM_9))
+#include "power_seq.h"
+#include "state_push.h"
+#include "restore_plan.h"
 
 static const char *TAG = "GPIO Handler";
 
 uint8_t restore_gpio_state(uint8_t gpio_num) {
-    nvs_handle_t nvs_handle;
     uint8_t value = 0;
-    char key[16];
-    snprintf(key, sizeof(key), "gpio_%d", gpio_num);
-
-    esp_err_t ret = nvs_open("storage", NVS_READONLY, &nvs_handle);
-    if (ret == ESP_OK) {
-        if (nvs_get_u8(nvs_handle, key, &value) == ESP_OK) {
-            if (value == 1) {
-                if (gpio_num == 0x22 || gpio_num == 0x26) {
-                    uint8_t sata_onpower = get_nvs_state(0x00, "sata_onpower");
-                    ESP_LOGI(TAG, "Waiting %d second/s for GPIO %d power-up", sata_onpower, gpio_num);
-                    sleep(sata_onpower);
-                }
+
+    if (read_nvs_state(gpio_num, "gpio", &value) == ESP_OK) {
+        uint32_t delay_ms = 0;
+        if (value == 1) {
+            if (gpio_num == 0x22 || gpio_num == 0x26) {
+                uint8_t sata_onpower = get_nvs_state(0x00, "sata_onpower");
+                ESP_LOGI(TAG, "Waiting %d second/s for GPIO %d power-up", sata_onpower, gpio_num);
+                delay_ms = sata_onpower * 1000;
             }
-            gpio_set_level(gpio_num, value);
-            ESP_LOGI(TAG, "Restored GPIO %d to value: %d", gpio_num, value);
-            return value;
-        } else {
-            gpio_set_level(gpio_num, 0);
-            ESP_LOGW(TAG, "No saved state for GPIO %d, set to 0", gpio_num);
-            save_state(gpio_num, 0, "gpio"); // 确保在 NVS 中保存默认状态
-            ESP_LOGI(TAG, "Default state saved for GPIO %d", gpio_num);
-            return 0;
         }
-        nvs_close(nvs_handle);
+        power_seq_request(gpio_num, value, delay_ms);
+        ESP_LOGI(TAG, "Restored GPIO %d to value: %d", gpio_num, value);
+        return value;
     } else {
-        gpio_set_level(gpio_num, 0);
-        ESP_LOGE(TAG, "NVS open failed (0x%x): GPIO %d set to 0", ret, gpio_num);
+        power_seq_request(gpio_num, 0, 0);
+        ESP_LOGW(TAG, "No saved state for GPIO %d, set to 0", gpio_num);
         save_state(gpio_num, 0, "gpio"); // 确保在 NVS 中保存默认状态
         ESP_LOGI(TAG, "Default state saved for GPIO %d", gpio_num);
         return 0;
@@ -50,67 +35,89 @@ uint8_t restore_gpio_state(uint8_t gpio_num) {
 }
 
 uint8_t ext_restore_gpio_state(uint8_t gpio_num) {
-    nvs_handle_t nvs_handle;
     uint8_t value = 0;
-    char key[16];
-    snprintf(key, sizeof(key), "ext_gpio_%d", gpio_num);
-
-    esp_err_t ret = nvs_open("storage", NVS_READONLY, &nvs_handle);
-    if (ret == ESP_OK) {
-        if (nvs_get_u8(nvs_handle, key, &value) == ESP_OK) {
-            if (value == 1) {
-                if (gpio_num == 0x22 || gpio_num == 0x26) {
-                    uint8_t sata_onpower = get_nvs_state(0x00, "sata_onpower");
-                    ESP_LOGI(TAG, "Waiting %d second/s for EXT-GPIO %d power-up", sata_onpower, gpio_num);
-                    sleep(sata_onpower);
-                }
+
+    if (read_nvs_state(gpio_num, "ext_gpio", &value) == ESP_OK) {
+        uint32_t delay_ms = 0;
+        if (value == 1) {
+            if (gpio_num == 0x22 || gpio_num == 0x26) {
+                uint8_t sata_onpower = get_nvs_state(0x00, "sata_onpower");
+                ESP_LOGI(TAG, "Waiting %d second/s for EXT-GPIO %d power-up", sata_onpower, gpio_num);
+                delay_ms = sata_onpower * 1000;
             }
-            gpio_set_level(gpio_num, value);
-            ESP_LOGI(TAG, "Restored GPIO %d to value when ext-powered: %d", gpio_num, value);
-            return value;
-        } else {
-            gpio_set_level(gpio_num, 0);
-            ESP_LOGW(TAG, "No saved state for GPIO when ext-powered: %d, set to 0", gpio_num);
-            save_state(gpio_num, 0, "gpio"); // 确保在 NVS 中保存默认状态
-            ESP_LOGI(TAG, "Default state saved for GPIO when ext-powered: %d", gpio_num);
-            return 0;
         }
-        nvs_close(nvs_handle);
+        power_seq_request(gpio_num, value, delay_ms);
+        ESP_LOGI(TAG, "Restored GPIO %d to value when ext-powered: %d", gpio_num, value);
+        return value;
     } else {
-        gpio_set_level(gpio_num, 0);
-        ESP_LOGE(TAG, "NVS open failed (0x%x): GPIO when ext-powered %d set to 0", ret, gpio_num);
+        power_seq_request(gpio_num, 0, 0);
+        ESP_LOGW(TAG, "No saved state for GPIO when ext-powered: %d, set to 0", gpio_num);
         save_state(gpio_num, 0, "gpio"); // 确保在 NVS 中保存默认状态
         ESP_LOGI(TAG, "Default state saved for GPIO when ext-powered: %d", gpio_num);
         return 0;
     }
 }
 
+// 以寄存器方式同时写多个输出：每个 bank 一次 W1TS 与一次 W1TC
+void gpio_write_port(uint64_t set_mask, uint64_t clear_mask) {
+    set_mask &= SWITCH_GPIO_MASK;
+    clear_mask &= SWITCH_GPIO_MASK & ~set_mask;
+    REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)clear_mask);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(clear_mask >> 32));
+    REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)set_mask);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(set_mask >> 32));
+}
+
+enum {
+    PLAN_NORMAL = 0,
+    PLAN_EXT_POWER,
+    PLAN_COUNT,
+};
+
+static restore_plan_t restore_plans[PLAN_COUNT];
+static uint32_t restore_plan_generation = UINT32_MAX;
+
 void restore_state(void) {
     uint8_t enclosure_state = enclosure_mode_selected();
+    bool ext_power = (enclosure_state == 0x00 && gpio_get_level(GPIO_NUM_1) == 1);
+    restore_plan_t plan;
 
-    if (enclosure_state == 0x00) {
-        if (gpio_get_level(GPIO_NUM_1) == 1) {
-            ext_restore_gpio_state(GPIO_NUM_33);
-            ext_restore_gpio_state(GPIO_NUM_34);
-            ext_restore_gpio_state(GPIO_NUM_35);
-            ext_restore_gpio_state(GPIO_NUM_38);
-            ext_restore_gpio_state(GPIO_NUM_45);
-        } else {
-            restore_gpio_state(GPIO_NUM_33);
-            restore_gpio_state(GPIO_NUM_34);
-            restore_gpio_state(GPIO_NUM_35);
-            restore_gpio_state(GPIO_NUM_38);
-            restore_gpio_state(GPIO_NUM_45);
+    // 在 nvs_lock 下读取镜像构建计划，避免与 save_state() 并发时读到一半更新的配置；同一把锁也保护计划缓存
+    config_lock();
+    if (restore_plan_generation != config_generation()) {
+        restore_plan_generation = config_generation();
+        restore_plan_build(&restore_plans[PLAN_NORMAL], get_config(), false);
+        restore_plan_build(&restore_plans[PLAN_EXT_POWER], get_config(), true);
+    }
+    plan = restore_plans[ext_power ? PLAN_EXT_POWER : PLAN_NORMAL];
+    config_unlock();
+
+    for (int i = 0; i < sizeof(restore_gpios); i++) {
+        if ((plan.clear_mask & (1ULL << restore_gpios[i])) && power_seq_is_slot(restore_gpios[i])) {
+            power_seq_note_level(restore_gpios[i], 0);
         }
-    } else {
-        restore_gpio_state(GPIO_NUM_33);
-        restore_gpio_state(GPIO_NUM_34);
-        restore_gpio_state(GPIO_NUM_35);
-        restore_gpio_state(GPIO_NUM_38);
-        restore_gpio_state(GPIO_NUM_45);
     }
-    restore_gpio_state(GPIO_NUM_36);
-    restore_gpio_state(GPIO_NUM_37);
+    gpio_write_port(plan.set_mask, plan.clear_mask);
+    state_push_notify();
+    for (int i = 0; i < plan.step_count; i++) {
+        power_seq_request(plan.steps[i].gpio_num, 1, plan.steps[i].delay_ms);
+    }
+    ESP_LOGI(TAG, "Restored %s plan: set 0x%llx clear 0x%llx, %d sequenced slot/s",
+             ext_power ? "ext-power" : "normal", (unsigned long long)plan.set_mask,
+             (unsigned long long)plan.clear_mask, plan.step_count);
+
+    if (plan.missing_mask) {
+        uint8_t pins[sizeof(restore_gpios)];
+        uint8_t zeros[sizeof(restore_gpios)] = {0};
+        int count = 0;
+        for (int i = 0; i < sizeof(restore_gpios); i++) {
+            if (plan.missing_mask & (1ULL << restore_gpios[i])) {
+                pins[count++] = restore_gpios[i];
+            }
+        }
+        // 确保在 NVS 中保存默认状态
+        save_state_batch(pins, zeros, count, "gpio");
+    }
 }
 
 void gpio_initialized() {
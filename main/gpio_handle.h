@@ -2,10 +2,17 @@
 #define GPIO_HANDLE_H
 
 #include <stdint.h>
+#include "driver/gpio.h"
+
+#define SWITCH_GPIO_MASK ((1ULL << GPIO_NUM_14) | (1ULL << GPIO_NUM_21) | (1ULL << GPIO_NUM_33) | (1ULL << GPIO_NUM_34) | (1ULL << GPIO_NUM_35) | (1ULL << GPIO_NUM_36)  | (1ULL << GPIO_NUM_37)  | (1ULL << GPIO_NUM_38)  | (1ULL << GPIO_NUM_45))
+#define HDDPC_GPIO_MASK ((1ULL << GPIO_NUM_11) | (1ULL << GPIO_NUM_12) | (1ULL << GPIO_NUM_13))
+#define PWR_GPIO_MASK ((1ULL << GPIO_NUM_1))
+#define IO_GPIO_MASK ((1ULL << GPIO_NUM_9))
 
 uint8_t restore_gpio_state(uint8_t gpio_num);
 uint8_t ext_restore_gpio_state(uint8_t gpio_num);
 void restore_state(void);
+void gpio_write_port(uint64_t set_mask, uint64_t clear_mask);
 void gpio_initialized();
 
 #endif
\ No newline at end of file
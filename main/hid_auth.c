@@ -0,0 +1,135 @@
+#include <string.h>
+#include <psa/crypto.h>
+#include "esp_log.h"
+#include "hid_auth.h"
+
+static const char *TAG = "HID Auth";
+#define HMAC_KEY        "a0HyIvVM6A6Z7dTPYrAk8s3Mpouh"
+#define HMAC_BLOCK_SIZE 64
+
+static psa_key_id_t hmac_key_id = PSA_KEY_ID_NULL;
+
+// HMAC-SHA256 的 (K ^ ipad) / (K ^ opad) 已吸收的哈希状态，每次计算时克隆
+static psa_hash_operation_t inner_state = PSA_HASH_OPERATION_INIT;
+static psa_hash_operation_t outer_state = PSA_HASH_OPERATION_INIT;
+static bool padded_state_ready = false;
+
+static bool precompute_padded_state(void) {
+    uint8_t ipad[HMAC_BLOCK_SIZE];
+    uint8_t opad[HMAC_BLOCK_SIZE];
+    size_t key_len = strlen(HMAC_KEY);
+
+    // 密钥长度小于块长，无需预先哈希
+    memset(ipad, 0x36, sizeof(ipad));
+    memset(opad, 0x5C, sizeof(opad));
+    for (size_t i = 0; i < key_len; i++) {
+        ipad[i] ^= (uint8_t)HMAC_KEY[i];
+        opad[i] ^= (uint8_t)HMAC_KEY[i];
+    }
+
+    bool ok = psa_hash_setup(&inner_state, PSA_ALG_SHA_256) == PSA_SUCCESS &&
+              psa_hash_update(&inner_state, ipad, sizeof(ipad)) == PSA_SUCCESS &&
+              psa_hash_setup(&outer_state, PSA_ALG_SHA_256) == PSA_SUCCESS &&
+              psa_hash_update(&outer_state, opad, sizeof(opad)) == PSA_SUCCESS;
+
+    memset(ipad, 0, sizeof(ipad));
+    memset(opad, 0, sizeof(opad));
+    if (!ok) {
+        psa_hash_abort(&inner_state);
+        psa_hash_abort(&outer_state);
+    }
+    return ok;
+}
+
+static bool padded_state_mac(const uint8_t *msg, size_t len, uint8_t *mac) {
+    psa_hash_operation_t op = PSA_HASH_OPERATION_INIT;
+    uint8_t inner_digest[HID_AUTH_MAC_LEN];
+    size_t digest_len;
+
+    if (psa_hash_clone(&inner_state, &op) != PSA_SUCCESS ||
+        psa_hash_update(&op, msg, len) != PSA_SUCCESS ||
+        psa_hash_finish(&op, inner_digest, sizeof(inner_digest), &digest_len) != PSA_SUCCESS) {
+        psa_hash_abort(&op);
+        return false;
+    }
+    if (psa_hash_clone(&outer_state, &op) != PSA_SUCCESS ||
+        psa_hash_update(&op, inner_digest, sizeof(inner_digest)) != PSA_SUCCESS ||
+        psa_hash_finish(&op, mac, HID_AUTH_MAC_LEN, &digest_len) != PSA_SUCCESS) {
+        psa_hash_abort(&op);
+        return false;
+    }
+    return true;
+}
+
+esp_err_t hid_auth_init(void) {
+    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_usage_flags(&attributes, PSA_KEY_USAGE_SIGN_MESSAGE);
+    psa_set_key_algorithm(&attributes, PSA_ALG_HMAC(PSA_ALG_SHA_256));
+    psa_set_key_type(&attributes, PSA_KEY_TYPE_HMAC);
+
+    psa_status_t status = psa_import_key(&attributes, (const uint8_t *)HMAC_KEY, strlen(HMAC_KEY), &hmac_key_id);
+    if (status != PSA_SUCCESS) {
+        ESP_LOGE(TAG, "HMAC key import failed: %d", (int)status);
+        return ESP_FAIL;
+    }
+
+    padded_state_ready = precompute_padded_state();
+    if (!padded_state_ready) {
+        ESP_LOGW(TAG, "Hash clone unavailable, using imported key for every MAC");
+    }
+    return ESP_OK;
+}
+
+bool hid_auth_sign(const uint8_t *msg, size_t len, uint8_t *mac) {
+    size_t mac_len;
+
+    if (padded_state_ready && padded_state_mac(msg, len, mac)) {
+        return true;
+    }
+    if (psa_mac_compute(hmac_key_id, PSA_ALG_HMAC(PSA_ALG_SHA_256),
+                        msg, len, mac, HID_AUTH_MAC_LEN, &mac_len) != PSA_SUCCESS) {
+        memset(mac, 0, HID_AUTH_MAC_LEN);
+        return false;
+    }
+    return true;
+}
+
+static bool mac_equal(const uint8_t *a, const uint8_t *b) {
+    uint8_t diff = 0;
+    for (int i = 0; i < HID_AUTH_MAC_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+bool hid_auth_verify(const uint8_t *msg, size_t len, const uint8_t *mac) {
+    uint8_t calc_mac[HID_AUTH_MAC_LEN];
+
+    if (!hid_auth_sign(msg, len, calc_mac)) {
+        return false;
+    }
+    return mac_equal(calc_mac, mac);
+}
+
+// v2 帧的 MAC 为 HMAC(msg || HID_AUTH_V2_DOMAIN)：v1 帧(含 cmd 为 0xFD 的)的 MAC
+// 不可能通过 v2 校验，反之亦然，因此首字节相同时仍能区分两种格式
+bool hid_auth_sign_v2(const uint8_t *msg, size_t len, uint8_t *mac) {
+    uint8_t buf[HID_AUTH_V2_MSG_MAX + 1];
+
+    if (len > HID_AUTH_V2_MSG_MAX) {
+        memset(mac, 0, HID_AUTH_MAC_LEN);
+        return false;
+    }
+    memcpy(buf, msg, len);
+    buf[len] = HID_AUTH_V2_DOMAIN;
+    return hid_auth_sign(buf, len + 1, mac);
+}
+
+bool hid_auth_verify_v2(const uint8_t *msg, size_t len, const uint8_t *mac) {
+    uint8_t calc_mac[HID_AUTH_MAC_LEN];
+
+    if (!hid_auth_sign_v2(msg, len, calc_mac)) {
+        return false;
+    }
+    return mac_equal(calc_mac, mac);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef HID_AUTH_H
+#define HID_AUTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define HID_AUTH_MAC_LEN    32
+#define HID_AUTH_V2_MSG_MAX 32
+#define HID_AUTH_V2_DOMAIN  0x02   // v2 帧的 MAC 覆盖报文之后追加的域分隔字节
+
+esp_err_t hid_auth_init(void);
+bool hid_auth_sign(const uint8_t *msg, size_t len, uint8_t *mac);
+bool hid_auth_verify(const uint8_t *msg, size_t len, const uint8_t *mac);
+bool hid_auth_sign_v2(const uint8_t *msg, size_t len, uint8_t *mac);
+bool hid_auth_verify_v2(const uint8_t *msg, size_t len, const uint8_t *mac);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include <string.h>
+#include <psa/crypto.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "hid_ota.h"
+
+static const char *TAG = "HID OTA";
+
+#define OTA_FLASH_BATCH 4096   // 攒满一个扇区再写 flash
+
+// HID 命令与 vendor 批量通道都可能访问，公开函数都持有 ota_lock
+static SemaphoreHandle_t ota_lock = NULL;
+static struct {
+    ota_state_t state;
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    uint32_t size;
+    uint32_t offset;
+    uint32_t flash_writes;
+    int64_t start_us;
+    int32_t last_err;
+    psa_hash_operation_t sha;
+    uint8_t expected[OTA_HASH_LEN];
+    uint8_t expected_parts;   // bit0/bit1：两半摘要是否已收到
+} ota = { .sha = PSA_HASH_OPERATION_INIT };
+
+static uint8_t flash_buf[OTA_FLASH_BATCH];
+static uint32_t flash_buf_len = 0;
+
+static esp_err_t fail(esp_err_t err) {
+    ESP_LOGE(TAG, "OTA failed at offset %lu: %s", (unsigned long)ota.offset, esp_err_to_name(err));
+    if (ota.state == OTA_RECEIVING) {
+        esp_ota_abort(ota.handle);
+    }
+    psa_hash_abort(&ota.sha);
+    ota.state = OTA_FAILED;
+    ota.last_err = err;
+    flash_buf_len = 0;
+    return err;
+}
+
+static esp_err_t flush_batch(void) {
+    if (flash_buf_len == 0) {
+        return ESP_OK;
+    }
+    esp_err_t err = esp_ota_write(ota.handle, flash_buf, flash_buf_len);
+    if (err != ESP_OK) {
+        return fail(err);
+    }
+    ota.flash_writes++;
+    flash_buf_len = 0;
+    return ESP_OK;
+}
+
+void hid_ota_init(void) {
+    ota_lock = xSemaphoreCreateMutex();
+}
+
+static void abort_locked(void) {
+    if (ota.state == OTA_RECEIVING) {
+        esp_ota_abort(ota.handle);
+        ESP_LOGW(TAG, "OTA aborted at offset %lu", (unsigned long)ota.offset);
+    }
+    psa_hash_abort(&ota.sha);
+    ota.state = OTA_IDLE;
+    flash_buf_len = 0;
+}
+
+void hid_ota_abort(void) {
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    abort_locked();
+    xSemaphoreGive(ota_lock);
+}
+
+// 同样大小的会话仍在进行时直接续传，返回当前偏移
+static esp_err_t begin_locked(uint32_t size, uint32_t *resume_offset) {
+    if (ota.state == OTA_RECEIVING && ota.size == size) {
+        *resume_offset = ota.offset;
+        ESP_LOGI(TAG, "Resuming OTA at offset %lu", (unsigned long)ota.offset);
+        return ESP_OK;
+    }
+    abort_locked();
+    *resume_offset = 0;
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL) {
+        return fail(ESP_ERR_NOT_FOUND);
+    }
+    if (size == 0 || size > partition->size) {
+        return fail(ESP_ERR_INVALID_SIZE);
+    }
+    // 顺序写入时按需擦除扇区，begin 不会阻塞整个分区的擦除时间
+    esp_err_t err = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &ota.handle);
+    if (err != ESP_OK) {
+        return fail(err);
+    }
+    if (psa_hash_setup(&ota.sha, PSA_ALG_SHA_256) != PSA_SUCCESS) {
+        ota.state = OTA_RECEIVING;
+        return fail(ESP_FAIL);
+    }
+    ota.state = OTA_RECEIVING;
+    ota.partition = partition;
+    ota.size = size;
+    ota.offset = 0;
+    ota.flash_writes = 0;
+    ota.expected_parts = 0;
+    ota.last_err = ESP_OK;
+    ota.start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "OTA started: %lu bytes to %s", (unsigned long)size, partition->label);
+    return ESP_OK;
+}
+
+esp_err_t hid_ota_begin(uint32_t size, uint32_t *resume_offset) {
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    esp_err_t err = begin_locked(size, resume_offset);
+    xSemaphoreGive(ota_lock);
+    return err;
+}
+
+// 期望的 SHA-256 分两半发送，half 为 0/1
+esp_err_t hid_ota_set_hash(uint8_t half, const uint8_t *bytes) {
+    if (half > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (ota.state == OTA_RECEIVING) {
+        memcpy(ota.expected + half * (OTA_HASH_LEN / 2), bytes, OTA_HASH_LEN / 2);
+        ota.expected_parts |= 1 << half;
+        err = ESP_OK;
+    }
+    xSemaphoreGive(ota_lock);
+    return err;
+}
+
+// 只接受顺序数据；重发的旧块直接确认，跳跃的块返回期望偏移让主机回退
+static esp_err_t write_locked(uint32_t offset, const uint8_t *data, uint32_t len, uint32_t *next_offset) {
+    *next_offset = ota.offset;
+    if (ota.state != OTA_RECEIVING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len == 0 || offset + len > ota.size || offset + len < offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (offset != ota.offset) {
+        return (offset + len <= ota.offset) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    psa_hash_update(&ota.sha, data, len);
+    while (len > 0) {
+        uint32_t room = OTA_FLASH_BATCH - flash_buf_len;
+        uint32_t n = len < room ? len : room;
+        memcpy(flash_buf + flash_buf_len, data, n);
+        flash_buf_len += n;
+        ota.offset += n;
+        data += n;
+        len -= n;
+        if (flash_buf_len == OTA_FLASH_BATCH) {
+            esp_err_t err = flush_batch();
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    *next_offset = ota.offset;
+    return ESP_OK;
+}
+
+esp_err_t hid_ota_write(uint32_t offset, const uint8_t *data, uint32_t len, uint32_t *next_offset) {
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    esp_err_t err = write_locked(offset, data, len, next_offset);
+    xSemaphoreGive(ota_lock);
+    return err;
+}
+
+// 写完剩余数据，校验摘要与镜像后切换启动分区
+static esp_err_t commit_locked(void) {
+    if (ota.state != OTA_RECEIVING || ota.offset != ota.size || ota.expected_parts != 0x03) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = flush_batch();
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (psa_hash_verify(&ota.sha, ota.expected, OTA_HASH_LEN) != PSA_SUCCESS) {
+        return fail(ESP_ERR_INVALID_CRC);
+    }
+    err = esp_ota_end(ota.handle);
+    ota.state = OTA_FAILED;   // handle 已释放，之后的失败不再 abort
+    if (err != ESP_OK) {
+        return fail(err);
+    }
+    err = esp_ota_set_boot_partition(ota.partition);
+    if (err != ESP_OK) {
+        return fail(err);
+    }
+    ota.state = OTA_READY;
+    ESP_LOGI(TAG, "OTA image verified, next boot from %s", ota.partition->label);
+    return ESP_OK;
+}
+
+esp_err_t hid_ota_commit(void) {
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    esp_err_t err = commit_locked();
+    xSemaphoreGive(ota_lock);
+    return err;
+}
+
+void hid_ota_get_status(ota_status_t *out) {
+    xSemaphoreTake(ota_lock, portMAX_DELAY);
+    uint32_t elapsed_ms = ota.state == OTA_IDLE ? 0 : (uint32_t)((esp_timer_get_time() - ota.start_us) / 1000);
+
+    out->state = ota.state;
+    out->size = ota.size;
+    out->offset = ota.offset;
+    out->elapsed_ms = elapsed_ms;
+    out->bytes_per_s = elapsed_ms ? (uint32_t)((uint64_t)ota.offset * 1000 / elapsed_ms) : 0;
+    out->flash_writes = ota.flash_writes;
+    out->last_err = ota.last_err;
+    xSemaphoreGive(ota_lock);
+}
\ No newline at end of file
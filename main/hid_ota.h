@@ -0,0 +1,35 @@
+#ifndef HID_OTA_H
+#define HID_OTA_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define OTA_CHUNK_MAX   24     // v1/v2 帧都能容纳的单帧数据长度
+#define OTA_HASH_LEN    32
+
+typedef enum {
+    OTA_IDLE = 0,
+    OTA_RECEIVING,
+    OTA_READY,       // 已校验并切换启动分区，等待重启
+    OTA_FAILED,
+} ota_state_t;
+
+typedef struct {
+    uint8_t state;
+    uint32_t size;
+    uint32_t offset;          // 下一个期望的偏移，也是断点续传位置
+    uint32_t bytes_per_s;
+    uint32_t elapsed_ms;
+    uint32_t flash_writes;
+    int32_t last_err;
+} ota_status_t;
+
+void hid_ota_init(void);
+esp_err_t hid_ota_begin(uint32_t size, uint32_t *resume_offset);
+esp_err_t hid_ota_set_hash(uint8_t half, const uint8_t *bytes);
+esp_err_t hid_ota_write(uint32_t offset, const uint8_t *data, uint32_t len, uint32_t *next_offset);
+esp_err_t hid_ota_commit(void);
+void hid_ota_abort(void);
+void hid_ota_get_status(ota_status_t *out);
+
+#endif
\ No newline at end of file
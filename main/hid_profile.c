@@ -0,0 +1,88 @@
+#include "esp_log.h"
+#include "tinyusb.h"
+#include "tusb.h"
+#include "class/hid/hid_device.h"
+#include "hid_profile.h"
+#include "nvs_handle.h"
+
+static const char *TAG = "HID Profile";
+
+#define REPORT_SIZE   64
+#define EPNUM_HID_OUT 0x01
+#define EPNUM_HID_IN  0x81
+
+// CONFIG_TINYUSB_VENDOR_COUNT > 0 时在 HID 之后附加 vendor 批量接口(见 vendor_bulk.c)
+#if CFG_TUD_VENDOR
+#define ITF_NUM_VENDOR      1
+#define EPNUM_VENDOR_OUT    0x02
+#define EPNUM_VENDOR_IN     0x82
+#define VENDOR_EP_SIZE      64
+#define ITF_COUNT           2
+#define VENDOR_DESC_LEN     TUD_VENDOR_DESC_LEN
+#define VENDOR_DESCRIPTOR   TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 0, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, VENDOR_EP_SIZE),
+#else
+#define ITF_COUNT           1
+#define VENDOR_DESC_LEN     0
+#define VENDOR_DESCRIPTOR
+#endif
+
+const uint8_t hid_report_descriptor[] = {
+    TUD_HID_REPORT_DESC_GENERIC_INOUT(REPORT_SIZE)
+};
+
+#define LEGACY_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + VENDOR_DESC_LEN)
+static const uint8_t legacy_configuration_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COUNT, 0, LEGACY_DESC_TOTAL_LEN, 0x00, 100),
+    TUD_HID_DESCRIPTOR(0, 0, false, sizeof(hid_report_descriptor), EPNUM_HID_IN, REPORT_SIZE,
+                       CONFIG_RSODIUM_HID_LEGACY_INTERVAL_MS),
+    VENDOR_DESCRIPTOR
+};
+
+// 命令走中断 OUT 端点，不再经过 EP0 控制传输；TinyUSB 仍通过 tud_hid_set_report_cb 交付
+#define FAST_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_INOUT_DESC_LEN + VENDOR_DESC_LEN)
+static const uint8_t fast_configuration_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COUNT, 0, FAST_DESC_TOTAL_LEN, 0x00, 100),
+    TUD_HID_INOUT_DESCRIPTOR(0, 0, HID_ITF_PROTOCOL_NONE, sizeof(hid_report_descriptor), EPNUM_HID_OUT,
+                             EPNUM_HID_IN, REPORT_SIZE, CONFIG_RSODIUM_HID_FAST_INTERVAL_MS),
+    VENDOR_DESCRIPTOR
+};
+
+static uint8_t active_profile = CONFIG_RSODIUM_HID_PROFILE_DEFAULT;
+
+uint8_t hid_profile_stored(void) {
+    uint8_t profile;
+    if (read_nvs_state(0x00, "hid_prof", &profile) != ESP_OK || profile >= HID_PROFILE_COUNT) {
+        return CONFIG_RSODIUM_HID_PROFILE_DEFAULT;
+    }
+    return profile;
+}
+
+// 在 tinyusb_driver_install() 之前调用，描述符在安装后不能再改变
+uint8_t hid_profile_select(void) {
+    active_profile = hid_profile_stored();
+    ESP_LOGI(TAG, "HID profile %s, IN %d ms, OUT %s", active_profile == HID_PROFILE_FAST ? "fast" : "legacy",
+             hid_profile_in_interval(), active_profile == HID_PROFILE_FAST ? "interrupt" : "EP0");
+    return active_profile;
+}
+
+uint8_t hid_profile_active(void) {
+    return active_profile;
+}
+
+// 保存到 NVS，复位后生效
+void hid_profile_store(uint8_t profile) {
+    save_state(0x00, profile, "hid_prof");
+}
+
+const uint8_t *hid_profile_config_descriptor(void) {
+    return active_profile == HID_PROFILE_FAST ? fast_configuration_descriptor : legacy_configuration_descriptor;
+}
+
+uint8_t hid_profile_in_interval(void) {
+    return active_profile == HID_PROFILE_FAST ? CONFIG_RSODIUM_HID_FAST_INTERVAL_MS : CONFIG_RSODIUM_HID_LEGACY_INTERVAL_MS;
+}
+
+// 0 表示 OUT 走 EP0 SET_REPORT
+uint8_t hid_profile_out_interval(void) {
+    return active_profile == HID_PROFILE_FAST ? CONFIG_RSODIUM_HID_FAST_INTERVAL_MS : 0;
+}
\ No newline at end of file
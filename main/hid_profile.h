@@ -0,0 +1,20 @@
+#ifndef HID_PROFILE_H
+#define HID_PROFILE_H
+
+#include <stdint.h>
+
+#define HID_PROFILE_LEGACY 0x00   // 中断 IN + EP0 SET_REPORT OUT
+#define HID_PROFILE_FAST   0x01   // 中断 IN + 中断 OUT
+#define HID_PROFILE_COUNT  2
+
+extern const uint8_t hid_report_descriptor[];
+
+uint8_t hid_profile_select(void);
+uint8_t hid_profile_active(void);
+uint8_t hid_profile_stored(void);
+void hid_profile_store(uint8_t profile);
+const uint8_t *hid_profile_config_descriptor(void);
+uint8_t hid_profile_in_interval(void);
+uint8_t hid_profile_out_interval(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "tusb.h"
+#include "class/hid/hid_device.h"
+#include "hid_tx.h"
+
+static const char *TAG = "HID TX";
+
+#define REPORT_SIZE 64
+
+// 回复队列深度大于命令队列(8)加上 BUSY 回复的余量
+static const uint8_t queue_depth[HID_TX_PRIO_COUNT] = { 24, 4, 1 };
+
+static QueueHandle_t tx_queue[HID_TX_PRIO_COUNT];
+static SemaphoreHandle_t tx_lock = NULL;
+static volatile bool pump_pending = false;   // 有调用者因锁被占用而未能发送，持锁者释放后需要重新检查
+static hid_tx_stats_t tx_stats;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void hid_tx_init(void) {
+    for (int i = 0; i < HID_TX_PRIO_COUNT; i++) {
+        tx_queue[i] = xQueueCreate(queue_depth[i], REPORT_SIZE);
+    }
+    tx_lock = xSemaphoreCreateMutex();
+}
+
+static void count_drop(hid_tx_prio_t prio) {
+    portENTER_CRITICAL(&stats_lock);
+    tx_stats.dropped[prio]++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+// 端点空闲时按优先级发出一帧；其余帧在 tud_hid_report_complete_cb 中继续发送。
+// 不等待 tx_lock：锁被占用时只置位 pump_pending，由持锁者释放后代为发送，因此可在 TinyUSB 回调中调用
+void hid_tx_pump(void) {
+    uint8_t report[REPORT_SIZE];
+
+    pump_pending = true;
+    while (pump_pending) {
+        if (xSemaphoreTake(tx_lock, 0) != pdTRUE) {
+            return;
+        }
+        pump_pending = false;
+        if (tud_hid_ready()) {
+            for (int i = 0; i < HID_TX_PRIO_COUNT; i++) {
+                if (xQueueReceive(tx_queue[i], report, 0) != pdTRUE) {
+                    continue;
+                }
+                if (tud_hid_report(0, report, REPORT_SIZE)) {
+                    portENTER_CRITICAL(&stats_lock);
+                    tx_stats.sent++;
+                    portEXIT_CRITICAL(&stats_lock);
+                } else {
+                    // 放回队首，等下一次完成回调或健康检查时重试
+                    xQueueSendToFront(tx_queue[i], report, 0);
+                    portENTER_CRITICAL(&stats_lock);
+                    tx_stats.retries++;
+                    portEXIT_CRITICAL(&stats_lock);
+                }
+                break;
+            }
+        }
+        xSemaphoreGive(tx_lock);
+    }
+}
+
+// 不阻塞：可能在 TinyUSB 任务中调用（例如队列满时的 BUSY 回复）
+bool hid_tx_send(const uint8_t *report, hid_tx_prio_t prio) {
+    if (prio == HID_TX_HEARTBEAT) {
+        xQueueOverwrite(tx_queue[prio], report);
+    } else if (xQueueSend(tx_queue[prio], report, 0) != pdTRUE) {
+        if (prio == HID_TX_REPLY) {
+            count_drop(prio);
+            ESP_LOGW(TAG, "Reply queue full, dropping reply 0x%02X", report[0]);
+            hid_tx_pump();
+            return false;
+        }
+        // 推送只保留较新的帧
+        uint8_t stale[REPORT_SIZE];
+        xQueueReceive(tx_queue[prio], stale, 0);
+        xQueueSend(tx_queue[prio], report, 0);
+        count_drop(prio);
+    }
+
+    if (prio == HID_TX_REPLY) {
+        uint32_t depth = uxQueueMessagesWaiting(tx_queue[prio]);
+        portENTER_CRITICAL(&stats_lock);
+        if (depth > tx_stats.reply_high_water) {
+            tx_stats.reply_high_water = depth;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+    }
+    hid_tx_pump();
+    return true;
+}
+
+// 主机断开后队列中的帧已无意义
+void hid_tx_reset(void) {
+    uint8_t report[REPORT_SIZE];
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    for (int i = 0; i < HID_TX_PRIO_COUNT; i++) {
+        while (xQueueReceive(tx_queue[i], report, 0) == pdTRUE) {
+            count_drop(i);
+        }
+    }
+    xSemaphoreGive(tx_lock);
+    // 持锁期间被推迟的发送
+    if (pump_pending) {
+        hid_tx_pump();
+    }
+}
+
+void hid_tx_get_stats(hid_tx_stats_t *out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = tx_stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef HID_TX_H
+#define HID_TX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 数值越小优先级越高
+typedef enum {
+    HID_TX_REPLY = 0,    // 命令回复，不允许静默丢弃
+    HID_TX_PUSH,         // 状态推送
+    HID_TX_HEARTBEAT,    // 心跳，只保留最新一帧
+    HID_TX_PRIO_COUNT
+} hid_tx_prio_t;
+
+typedef struct {
+    uint32_t sent;
+    uint32_t retries;                      // tud_hid_report() 失败后留在队列中重试的次数
+    uint32_t dropped[HID_TX_PRIO_COUNT];   // 队列满或断开时丢弃/被覆盖的帧
+    uint32_t reply_high_water;
+} hid_tx_stats_t;
+
+void hid_tx_init(void);
+bool hid_tx_send(const uint8_t *report, hid_tx_prio_t prio);
+void hid_tx_pump(void);
+void hid_tx_reset(void);
+void hid_tx_get_stats(hid_tx_stats_t *out);
+
+#endif
\ No newline at end of file
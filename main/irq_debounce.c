@@ -0,0 +1,60 @@
+#include "irq_debounce.h"
+
+// 重复注册同一引脚时保留已有统计
+void debounce_pin_init(debounce_pin_t *pin, uint8_t gpio_num, uint8_t level, uint8_t window_ms) {
+    pin->stats.gpio_num = gpio_num;
+    pin->waiting = false;
+    pin->latest_level = level;
+    pin->settled_level = level;
+    pin->last_edge_us = 0;
+    debounce_pin_set_window(pin, window_ms);
+}
+
+void debounce_pin_set_window(debounce_pin_t *pin, uint8_t window_ms) {
+    pin->debounce_us = window_ms * 1000;
+}
+
+// 一次取出环形缓冲中的全部边沿；防抖窗口内的多个边沿合并为最后一次的电平
+// ISR 只记录 32 位时间戳，按与 now 的差值还原为 64 位
+void edge_ring_drain(edge_ring_t *ring, debounce_pin_t *const pin_by_gpio[], int64_t now) {
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    while (tail != head) {
+        const edge_record_t *rec = &ring->rec[tail & (EDGE_RING_SIZE - 1)];
+        debounce_pin_t *pin = pin_by_gpio[rec->gpio_num];
+        if (pin->waiting) {
+            pin->stats.coalesced++;
+        }
+        pin->waiting = true;
+        pin->last_edge_us = now - (int64_t)(uint32_t)((uint32_t)now - rec->timestamp_us);
+        pin->latest_level = rec->level;
+        tail++;
+    }
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+// 返回距离防抖窗口结束的剩余时间，未在等待时返回 -1
+int64_t debounce_remaining_us(const debounce_pin_t *pin, int64_t now) {
+    if (!pin->waiting) {
+        return -1;
+    }
+    int64_t remain_us = pin->last_edge_us + pin->debounce_us - now;
+    return remain_us > 0 ? remain_us : 0;
+}
+
+// 窗口结束且电平与上次稳定值不同时返回 true 并给出新电平；抖动后回到原电平计为 filtered
+bool debounce_settle(debounce_pin_t *pin, int64_t now, uint8_t *level) {
+    if (!pin->waiting || now - pin->last_edge_us < pin->debounce_us) {
+        return false;
+    }
+    pin->waiting = false;
+    if (pin->latest_level == pin->settled_level) {
+        pin->stats.filtered++;
+        return false;
+    }
+    pin->settled_level = pin->latest_level;
+    pin->stats.events++;
+    *level = pin->settled_level;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef IRQ_DEBOUNCE_H
+#define IRQ_DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DEBOUNCE_DEFAULT_MS 20
+#define EDGE_RING_SIZE      64   // 必须为 2 的幂
+
+// events: 分发给回调的稳定事件；coalesced: 防抖窗口内被合并的边沿；filtered: 稳定后电平未变化而丢弃的事件；dropped: 环形缓冲满时丢失的边沿
+typedef struct {
+    uint8_t gpio_num;
+    uint32_t events;
+    uint32_t coalesced;
+    uint32_t filtered;
+    uint32_t dropped;
+} irq_pin_stats_t;
+
+typedef struct {
+    uint8_t gpio_num;
+    uint8_t level;
+    uint32_t timestamp_us;
+} edge_record_t;
+
+// 单生产者(ISR)/单消费者(hddpc_task)无锁环形缓冲，满时丢弃新边沿
+typedef struct {
+    edge_record_t rec[EDGE_RING_SIZE];
+    uint32_t head;
+    uint32_t tail;
+} edge_ring_t;
+
+// 单个中断引脚的防抖状态
+typedef struct {
+    irq_pin_stats_t stats;
+    bool waiting;
+    uint8_t latest_level;
+    uint8_t settled_level;
+    uint32_t debounce_us;
+    int64_t last_edge_us;
+} debounce_pin_t;
+
+// 在 ISR 中调用，强制内联以免从 flash 取指；返回 false 表示缓冲已满
+static inline __attribute__((always_inline)) bool edge_ring_push(edge_ring_t *ring, uint8_t gpio_num, uint8_t level, uint32_t timestamp_us) {
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= EDGE_RING_SIZE) {
+        return false;
+    }
+    edge_record_t *rec = &ring->rec[head & (EDGE_RING_SIZE - 1)];
+    rec->gpio_num = gpio_num;
+    rec->level = level;
+    rec->timestamp_us = timestamp_us;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void debounce_pin_init(debounce_pin_t *pin, uint8_t gpio_num, uint8_t level, uint8_t window_ms);
+void debounce_pin_set_window(debounce_pin_t *pin, uint8_t window_ms);
+void edge_ring_drain(edge_ring_t *ring, debounce_pin_t *const pin_by_gpio[], int64_t now);
+int64_t debounce_remaining_us(const debounce_pin_t *pin, int64_t now);
+bool debounce_settle(debounce_pin_t *pin, int64_t now, uint8_t *level);
+
+#endif
\ No newline at end of file
@@ -2,133 +2,214 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "irq_queue.h"
 #include "gpio_handle.h"
 #include "nvs_handle.h"
+#include "power_seq.h"
+#include "state_push.h"
 
 static const char *TAG = "HDDPC Event";
 
+#define MAX_IRQ_PINS        8
+
 hddpc_callback_t hddpc_callbacks[GPIO_NUM_MAX];
 
 EventGroupHandle_t hddpc_event_group;
 
-QueueHandle_t hddpc_evt_queue = NULL;
+static DRAM_ATTR edge_ring_t edge_ring;
+static DRAM_ATTR TaskHandle_t hddpc_task_handle = NULL;
+
+// 防抖判定与环形缓冲下标逻辑见 irq_debounce.c
+static debounce_pin_t irq_pins[MAX_IRQ_PINS];
+static DRAM_ATTR debounce_pin_t *pin_by_gpio[GPIO_NUM_MAX];
+static int irq_pin_count = 0;
+static int64_t dispatch_edge_us = 0;   // 正在分发的稳定电平对应边沿的 ISR 时间戳，供回调计算供电轨延迟
 
 static void IRAM_ATTR hddpc_isr_handler(void* arg) {
     int gpio_num = (int) arg;
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(hddpc_evt_queue, &gpio_num, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
+
+    if (!edge_ring_push(&edge_ring, gpio_num, gpio_get_level(gpio_num), (uint32_t)esp_timer_get_time())) {
+        pin_by_gpio[gpio_num]->stats.dropped++;
+    }
+
+    if (hddpc_task_handle != NULL) {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(hddpc_task_handle, &xHigherPriorityTaskWoken);
+        if (xHigherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+static void dispatch_settled(debounce_pin_t *pin, uint8_t level) {
+    int gpio_num = pin->stats.gpio_num;
+    dispatch_edge_us = pin->last_edge_us;
+    if (hddpc_callbacks[gpio_num]) {
+        hddpc_callbacks[gpio_num](gpio_num, level);
+        state_push_notify();
+    } else {
+        ESP_LOGW(TAG, "No callback for GPIO %d", gpio_num);
     }
 }
 
 void hddpc_task(void* arg) {
-    int gpio_num;
+    hddpc_task_handle = xTaskGetCurrentTaskHandle();
     for (;;) {
-        if (xQueueReceive(hddpc_evt_queue, &gpio_num, portMAX_DELAY)) {
-            if (hddpc_callbacks[gpio_num]) {
-                hddpc_callbacks[gpio_num](gpio_num);
-            } else {
-                ESP_LOGW(TAG, "No callback for GPIO %d", gpio_num);
+        TickType_t timeout = portMAX_DELAY;
+        int64_t now = esp_timer_get_time();
+        for (int i = 0; i < irq_pin_count; i++) {
+            int64_t remain_us = debounce_remaining_us(&irq_pins[i], now);
+            if (remain_us >= 0) {
+                TickType_t ticks = remain_us > 0 ? pdMS_TO_TICKS((remain_us + 999) / 1000) + 1 : 0;
+                if (ticks < timeout) {
+                    timeout = ticks;
+                }
+            }
+        }
+
+        ulTaskNotifyTake(pdTRUE, timeout);
+        edge_ring_drain(&edge_ring, pin_by_gpio, esp_timer_get_time());
+
+        now = esp_timer_get_time();
+        for (int i = 0; i < irq_pin_count; i++) {
+            uint8_t level;
+            if (debounce_settle(&irq_pins[i], now, &level)) {
+                dispatch_settled(&irq_pins[i], level);
             }
         }
     }
 }
 
 void gpio_register_callback(gpio_num_t gpio_num, hddpc_callback_t callback) {
+    uint8_t window_ms;
+    if (read_nvs_state(gpio_num, "debounce", &window_ms) != ESP_OK) {
+        window_ms = DEBOUNCE_DEFAULT_MS;
+    }
+    if (pin_by_gpio[gpio_num] == NULL) {
+        if (irq_pin_count >= MAX_IRQ_PINS) {
+            ESP_LOGE(TAG, "Too many IRQ pins, GPIO %d not registered", gpio_num);
+            return;
+        }
+        pin_by_gpio[gpio_num] = &irq_pins[irq_pin_count];
+        irq_pin_count++;
+    }
+    debounce_pin_init(pin_by_gpio[gpio_num], gpio_num, gpio_get_level(gpio_num), window_ms);
     hddpc_callbacks[gpio_num] = callback;
     gpio_isr_handler_add(gpio_num, hddpc_isr_handler, (void*) gpio_num);
 }
 
-void hddpc3_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
-    ESP_LOGW(TAG, "HDDPC3 (NVMe | GPIO%d) triggered: %d", gpio_num, _level);
+void irq_set_debounce(uint8_t gpio_num, uint8_t window_ms) {
+    if (gpio_num >= GPIO_NUM_MAX) {
+        return;
+    }
+    save_state(gpio_num, window_ms, "debounce");
+    if (pin_by_gpio[gpio_num] != NULL) {
+        debounce_pin_set_window(pin_by_gpio[gpio_num], window_ms);
+    }
+}
+
+int irq_get_pin_stats(irq_pin_stats_t *stats, int max) {
+    int count = irq_pin_count < max ? irq_pin_count : max;
+    for (int i = 0; i < count; i++) {
+        stats[i] = irq_pins[i].stats;
+    }
+    return count;
+}
+
+// 先写供电轨再打印日志，日志输出不计入边沿到供电轨的延迟
+void hddpc3_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
+    power_seq_note_edge(GPIO_NUM_45, _level, dispatch_edge_us);
     if (_level == 0) {
-        gpio_set_level(GPIO_NUM_45, 0);
+        power_seq_request(GPIO_NUM_45, 0, 0);
         ESP_LOGW(TAG,"NVMe Power Down");
     } else {
-        gpio_set_level(GPIO_NUM_45, 1);
+        power_seq_request(GPIO_NUM_45, 1, 0);
         ESP_LOGW(TAG,"NVMe Power UP");
     }
+    ESP_LOGW(TAG, "HDDPC3 (NVMe | GPIO%d) triggered: %d", gpio_num, _level);
 }
 
-void hddpc2_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
-    uint8_t hdd_state;
-    if (gpio_get_level(GPIO_NUM_1) == 1) {
-        hdd_state = ext_restore_gpio_state(GPIO_NUM_38);
-    } else {
-        hdd_state = restore_gpio_state(GPIO_NUM_38);
-    }
-    ESP_LOGW(TAG, "HDDPC2 (SATA2 | M.2 | GPIO%d) triggered: %d", gpio_num, _level);
+void hddpc2_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
+    power_seq_note_edge(GPIO_NUM_38, _level, dispatch_edge_us);
     if (_level == 0) {
-        gpio_set_level(GPIO_NUM_38, 0);
+        power_seq_request(GPIO_NUM_38, 0, 0);
         ESP_LOGW(TAG,"SATA2 (M.2) Power Down");
     } else if (_level == 1) {
+        // 按保存状态恢复，需要上电时由时序器在 sata_onpower 之后执行
+        uint8_t hdd_state;
+        if (gpio_get_level(GPIO_NUM_1) == 1) {
+            hdd_state = ext_restore_gpio_state(GPIO_NUM_38);
+        } else {
+            hdd_state = restore_gpio_state(GPIO_NUM_38);
+        }
         if (hdd_state == 1) {
-            gpio_set_level(GPIO_NUM_38, 1);
             ESP_LOGW(TAG,"SATA2 (M.2) Power Up");
         }
     }
+    ESP_LOGW(TAG, "HDDPC2 (SATA2 | M.2 | GPIO%d) triggered: %d", gpio_num, _level);
 }
 
-void hddpc1_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
-    uint8_t hdd_state;
-    if (gpio_get_level(GPIO_NUM_1) == 1) {
-        hdd_state = ext_restore_gpio_state(GPIO_NUM_34);
-    } else {
-        hdd_state = restore_gpio_state(GPIO_NUM_34);
-    }
-    ESP_LOGW(TAG, "HDDPC1 (SATA1 | 2.5 | GPIO%d) triggered: %d", gpio_num, _level);
+void hddpc1_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
+    power_seq_note_edge(GPIO_NUM_34, _level, dispatch_edge_us);
     if (_level == 0) {
-        gpio_set_level(GPIO_NUM_34, 0);
+        power_seq_request(GPIO_NUM_34, 0, 0);
         ESP_LOGW(TAG,"SATA1 (2.5) Power Down");
     } else if (_level == 1) {
+        // 按保存状态恢复，需要上电时由时序器在 sata_onpower 之后执行
+        uint8_t hdd_state;
+        if (gpio_get_level(GPIO_NUM_1) == 1) {
+            hdd_state = ext_restore_gpio_state(GPIO_NUM_34);
+        } else {
+            hdd_state = restore_gpio_state(GPIO_NUM_34);
+        }
         if (hdd_state == 1) {
-            gpio_set_level(GPIO_NUM_34, 1);
             ESP_LOGW(TAG,"SATA1 (2.5) Power Up");
         }
     }
-    
+    ESP_LOGW(TAG, "HDDPC1 (SATA1 | 2.5 | GPIO%d) triggered: %d", gpio_num, _level);
 }
 
-void SATA1_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
+void SATA1_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
     uint8_t hddpc_state = gpio_get_level(GPIO_NUM_11);
     ESP_LOGW(TAG, "SATA1 Power (2.5 | GPIO%d) triggered: %d", gpio_num, _level);
     if (_level == 1) {
         if (hddpc_state == 1) {
-            gpio_set_level(GPIO_NUM_34, 1);
-            ESP_LOGW(TAG,"SATA1 (2.5) Power Up");
+            // 经上电时序器执行，受起转并发数与间隔策略约束
+            power_seq_request(GPIO_NUM_34, 1, 0);
+            ESP_LOGW(TAG,"SATA1 (2.5) Power Up requested");
         }
     }
 }
 
-void SATA2_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
+void SATA2_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
     uint8_t hddpc_state = gpio_get_level(GPIO_NUM_12);
     ESP_LOGW(TAG, "SATA2 Power (M.2 | GPIO%d) triggered: %d", gpio_num, _level);
     if (_level == 1) {
         if (hddpc_state == 1) {
-            gpio_set_level(GPIO_NUM_38, 1);
-            ESP_LOGW(TAG,"SATA2 (M.2) Power Up");
+            // 经上电时序器执行，受起转并发数与间隔策略约束
+            power_seq_request(GPIO_NUM_38, 1, 0);
+            ESP_LOGW(TAG,"SATA2 (M.2) Power Up requested");
         }
     }
 }
 
-void bus_power_callback(int gpio_num) {
-    uint8_t _level = gpio_get_level(gpio_num);
+void bus_power_callback(int gpio_num, uint8_t level) {
+    uint8_t _level = level;
     ESP_LOGW(TAG, "Bus power triggered: %d, ESP32 RESET", _level);
     uint8_t ext_restart_value = get_nvs_state(0x00, "ext_restart");
     if (ext_restart_value == 0x01) {
     // restore_state();
+        nvs_flush_state(true);
         esp_restart();
     }
     restore_state();
@@ -4,19 +4,21 @@
 #include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "irq_debounce.h"
 
-typedef void (*hddpc_callback_t)(int gpio_num);
+typedef void (*hddpc_callback_t)(int gpio_num, uint8_t level);
 
 void hddpc_task(void* arg);
-extern QueueHandle_t hddpc_evt_queue;
 
-void hddpc1_callback(int gpio_num);
-void hddpc2_callback(int gpio_num);
-void hddpc3_callback(int gpio_num);
-void SATA1_callback(int gpio_num);
-void SATA2_callback(int gpio_num);
-void bus_power_callback(int gpio_num);
+void hddpc1_callback(int gpio_num, uint8_t level);
+void hddpc2_callback(int gpio_num, uint8_t level);
+void hddpc3_callback(int gpio_num, uint8_t level);
+void SATA1_callback(int gpio_num, uint8_t level);
+void SATA2_callback(int gpio_num, uint8_t level);
+void bus_power_callback(int gpio_num, uint8_t level);
 void gpio_register_callback(gpio_num_t gpio_num, hddpc_callback_t callback);
+void irq_set_debounce(uint8_t gpio_num, uint8_t window_ms);
+int irq_get_pin_stats(irq_pin_stats_t *stats, int max);
 
 #endif
\ No newline at end of file
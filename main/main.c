@@ -19,20 +19,24 @@
 #include "process_commander.h"
 #include "irq_queue.h"
 #include "alive_hid.h"
+#include "hid_auth.h"
+#include "cmd_worker.h"
+#include "power_seq.h"
+#include "event_log.h"
+#include "boot_prof.h"
+#include "usb_health.h"
+#include "hid_profile.h"
+#include "hid_tx.h"
+#include "hid_ota.h"
+#include "vendor_bulk.h"
 
-static volatile bool usb_reenum_req = false;
 static volatile bool usb_mounted = false;
-static volatile bool usb_init_ready = false;
 
 static const char *TAG = "R-SODIUM Controller";
 #define REPORT_SIZE 64
-#define HMAC_KEY    "a0HyIvVM6A6Z7dTPYrAk8s3Mpouh"
 #define ESP_INTR_FLAG_DEFAULT 0
 
 static volatile bool gpio_int_flag = false;
-const uint8_t hid_report_descriptor[] = {
-    TUD_HID_REPORT_DESC_GENERIC_INOUT(REPORT_SIZE)
-};
 
 const tusb_desc_device_t hid_device_descriptor = {
     .bLength            = sizeof(tusb_desc_device_t),
@@ -59,12 +63,6 @@ const char* hid_string_descriptor[5] = {
     "R-SODIUM HID Controller",
 };
 
-#define TUSB_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
-static const uint8_t hid_configuration_descriptor[] = {
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUSB_DESC_TOTAL_LEN, 0x00, 100),
-    TUD_HID_DESCRIPTOR(0, 0, false, sizeof(hid_report_descriptor), 0x81, REPORT_SIZE, 10),
-};
-
 uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance) {
     return hid_report_descriptor;
 }
@@ -83,36 +81,13 @@ void tud_hid_set_report_cb(uint8_t instance,
                            hid_report_type_t report_type,
                            uint8_t const *buffer,
                            uint16_t bufsize) {
-    if (bufsize != REPORT_SIZE) {
-        ESP_LOGW(TAG, "Invalid report size");
-        return;
-    }
-
-    uint8_t command = buffer[0];
-    const uint8_t *payload = buffer + 1;
-    const uint8_t *recv_hmac = buffer + 32;
-    uint8_t calc_hmac[32];
-    size_t calc_hmac_len;
-
-    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
-    psa_set_key_usage_flags(&attributes, PSA_KEY_USAGE_SIGN_MESSAGE);
-    psa_set_key_algorithm(&attributes, PSA_ALG_HMAC(PSA_ALG_SHA_256));
-    psa_set_key_type(&attributes, PSA_KEY_TYPE_HMAC);
-
-    psa_key_id_t hmac_key_id;
-    psa_import_key(&attributes, (const uint8_t *)HMAC_KEY, strlen(HMAC_KEY), &hmac_key_id);
-    psa_mac_compute(hmac_key_id, PSA_ALG_HMAC(PSA_ALG_SHA_256),
-                    buffer, 32, calc_hmac, sizeof(calc_hmac), &calc_hmac_len);
-    psa_destroy_key(hmac_key_id);
-
-    if (memcmp(calc_hmac, recv_hmac, 32) != 0) {
-        ESP_LOGW(TAG, "HMAC mismatch");
-        return;
-    }
-    ESP_LOGI(TAG, "Received command: 0x%02X", command);
-    stop_hid_alive_task();
-    process_command(command, payload);
+    usb_health_on_host_rx();
+    cmd_worker_submit(buffer, bufsize);
+}
 
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len) {
+    cmd_worker_report_complete(report);
+    hid_tx_pump();
 }
 
 void tud_resume_cb(void) {
@@ -120,6 +95,7 @@ void tud_resume_cb(void) {
     restore_state();
     ESP_LOGW(TAG, "Host resumed, restore GPIO state");
     start_hid_alive_task();
+    usb_health_on_resume();
 
 }
 
@@ -127,11 +103,12 @@ static void detached_sleep_task(void *param)
 {
     vTaskDelay(pdMS_TO_TICKS(5000));
     gpio_set_level(GPIO_NUM_33, 0);
-    gpio_set_level(GPIO_NUM_34, 0);
+    power_seq_request(GPIO_NUM_34, 0, 0);
     gpio_set_level(GPIO_NUM_35, 0);
-    gpio_set_level(GPIO_NUM_38, 0);
-    gpio_set_level(GPIO_NUM_45, 0);
+    power_seq_request(GPIO_NUM_38, 0, 0);
+    power_seq_request(GPIO_NUM_45, 0, 0);
     ESP_LOGW(TAG, "Host unmounted, disable all GPIO");
+    nvs_flush_state(false);
     esp_sleep_enable_timer_wakeup(10000000);
     esp_light_sleep_start();
     vTaskDelete(NULL);
@@ -143,12 +120,17 @@ static void device_event_handler(tinyusb_event_t *event, void *arg)
     case TINYUSB_EVENT_ATTACHED:
         restore_state();
         ESP_LOGW(TAG, "Host mounted, restore GPIO state");
+        boot_prof_mark(BOOT_PHASE_USB_MOUNTED);
         start_hid_alive_task();
+        hid_alive_wake();
         usb_mounted = true;
+        usb_health_on_mount();
         break;
     case TINYUSB_EVENT_DETACHED:
         stop_hid_alive_task();
         usb_mounted = false;
+        hid_tx_reset();
+        usb_health_on_unmount();
         uint8_t suspend_enable = get_nvs_state(0x00, "ususp_en");
         if (suspend_enable != 0x00) {
             xTaskCreate(detached_sleep_task, "detached_sleep", 2048, NULL, 3, NULL);
@@ -188,68 +170,25 @@ static void device_event_handler(tinyusb_event_t *event, void *arg)
 void tud_reset_cb(void)
 {
     ESP_LOGW(TAG, "USB bus reset detected");
+    boot_prof_mark(BOOT_PHASE_USB_RESET);
     restore_state();
     start_hid_alive_task();
-    usb_reenum_req = true;
-}
-
-void rst_hid_task(void *param)
-{
-    while (!usb_init_ready) {
-        vTaskDelay(pdMS_TO_TICKS(50));
-    }
-    vTaskDelay(pdMS_TO_TICKS(500));
-
-    ESP_LOGI(TAG, "Waiting for USB to mount...");
-
-    int timeout_ms = 8000;
-    int elapsed = 0;
-    const int step = 200;
-
-    while (elapsed < timeout_ms) {
-        if (tud_mounted()) {
-            ESP_LOGI(TAG, "USB mounted successfully, no need to re-enum");
-            vTaskDelete(NULL);
-            return;
-        }
-        // ESP32-S2 known issue: device electrically connected but not enumerated.
-        // Detect this "stuck" state early and force recovery.
-        if (elapsed > 3000 && tud_connected() && !tud_mounted()) {
-            ESP_LOGW(TAG, "USB connected but not enumerated (stuck), forcing re-enum early...");
-            break;
-        }
-        vTaskDelay(pdMS_TO_TICKS(step));
-        elapsed += step;
-    }
-
-    ESP_LOGW(TAG, "USB not mounted, forcing re-enumeration...");
-    stop_hid_alive_task();
-    tud_disconnect();
-    // Two-phase delay: let host detect disconnect, then settle before reconnect
-    vTaskDelay(pdMS_TO_TICKS(500));
-    vTaskDelay(pdMS_TO_TICKS(800));
-    tud_connect();
-    vTaskDelay(pdMS_TO_TICKS(500));
-    start_hid_alive_task();
-    ESP_LOGI(TAG, "USB re-enumeration complete");
-
-    vTaskDelete(NULL);
-}
-
-void usb_task(void *param) {
-    while (1) {
-        tud_task();
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
+    usb_health_on_reset();
 }
 
 void app_main(void) {
+    boot_prof_init();
     ESP_LOGI(TAG, "R-SODIUM Ultra SSD Enclosure Controller Start");
 
     psa_crypto_init();
+    ESP_ERROR_CHECK(hid_auth_init());
+    boot_prof_mark(BOOT_PHASE_CRYPTO);
 
     init_nvs();
+    hid_profile_select();
+    boot_prof_mark(BOOT_PHASE_NVS);
     gpio_initialized();
+    power_seq_init();
 
     gpio_set_level(GPIO_NUM_21, 1);
     gpio_set_level(GPIO_NUM_33, 0);
@@ -257,8 +196,16 @@ void app_main(void) {
     gpio_set_level(GPIO_NUM_35, 0);
     gpio_set_level(GPIO_NUM_38, 0);
     gpio_set_level(GPIO_NUM_45, 0);
+    boot_prof_mark(BOOT_PHASE_GPIO);
 
     restore_state();
+    boot_prof_mark(BOOT_PHASE_RESTORE);
+
+    hid_tx_init();
+    hid_ota_init();
+    cmd_worker_start();
+    event_log_start_drain();
+    vendor_bulk_start();
 
     // const tinyusb_config_t tusb_cfg = {
     //     .device_descriptor = &hid_device_descriptor,
@@ -274,28 +221,25 @@ void app_main(void) {
     tusb_cfg.descriptor.device = &hid_device_descriptor;
     tusb_cfg.descriptor.string = hid_string_descriptor;
     tusb_cfg.descriptor.string_count = sizeof(hid_string_descriptor)/sizeof(hid_string_descriptor[0]);
-    tusb_cfg.descriptor.full_speed_config = hid_configuration_descriptor;
+    tusb_cfg.descriptor.full_speed_config = hid_profile_config_descriptor();
     tusb_cfg.phy.self_powered = true;
     tusb_cfg.phy.vbus_monitor_io = GPIO_NUM_9;
 
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
     ESP_LOGI(TAG, "Controller initialized");
+    boot_prof_mark(BOOT_PHASE_USB_INSTALL);
 
     // Force clean USB state: ROM bootloader may leave D+ pull-up enabled,
     // causing "port occupied but no device" on quick power-cycle. Explicit
     // disconnect+reconnect ensures clean enumeration on ESP32-S2.
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // The health monitor reconnects once the hold time has passed.
     tud_disconnect();
-    vTaskDelay(pdMS_TO_TICKS(300));
-    tud_connect();
-    vTaskDelay(pdMS_TO_TICKS(200));
+    TickType_t disconnect_tick = xTaskGetTickCount();
 
     start_hid_alive_task();
 
-    hddpc_evt_queue = xQueueCreate(10, sizeof(int));
-
-    xTaskCreate(hddpc_task, "hddpc_task", 2048, NULL, 5, NULL);
-    xTaskCreate(rst_hid_task, "rst_hid_task", 4096, NULL, 6, NULL);
+    // 回调链中有 restore_state()、上电时序器与 ESP_LOG 格式化，2048 字节余量不足
+    xTaskCreate(hddpc_task, "hddpc_task", 3072, NULL, 5, NULL);
 
     gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
 
@@ -308,6 +252,6 @@ void app_main(void) {
 
     gpio_set_level(GPIO_NUM_14, 1);
 
-    usb_init_ready = true;
-    ESP_LOGI(TAG, "USB init ready, rst_hid_task armed");
+    usb_health_start(disconnect_tick);
+    ESP_LOGI(TAG, "USB init ready, health monitor armed");
 }
\ No newline at end of file
@@ -1,4 +1,11 @@
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_crc.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "nvs_handle.h"
@@ -6,68 +13,457 @@
 
 static const char *TAG = "NVS Handler";
 
-uint8_t get_nvs_state(uint8_t gpio_num, const char *prefix) {
+#define NVS_FLUSH_DELAY_MS 1000
+#define MAX_DIRTY_KEYS     32
+#define WEAR_SAVE_EVERY    16   // 每 16 次提交持久化一次磨损计数
+
+#define CONFIG_BLOB_KEY     "config"
+#define CONFIG_BLOB_MAGIC   0x5243   // "RC"
+#define CONFIG_BLOB_VERSION 2
+
+// 只持久化实际使用的引脚：开关引脚的 gpio/ext_gpio、中断引脚的 debounce、硬盘槽位的 spin_prio 与全局项
+static const uint8_t switch_pins[] = {
+    GPIO_NUM_14, GPIO_NUM_21, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35,
+    GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_45,
+};
+static const uint8_t irq_pins[] = {
+    GPIO_NUM_1, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_34, GPIO_NUM_38,
+};
+static const uint8_t slot_pins[] = {
+    GPIO_NUM_34, GPIO_NUM_38, GPIO_NUM_45,
+};
+static const char *const scalar_keys[] = {
+    "enclosure_mode", "sata_onpower", "susp_en", "ususp_en",
+    "ext_restart", "spin_max", "spin_gap", "spin_time", "hid_prof",
+};
+
+#define CONFIG_KEY_COUNT (sizeof(switch_pins) * 2 + sizeof(irq_pins) + sizeof(slot_pins) + \
+                          sizeof(scalar_keys) / sizeof(scalar_keys[0]))
+
+typedef struct {
+    const char *prefix;
+    uint8_t gpio_num;
+    config_entry_t *entry;
+} config_key_t;
+
+// 配置 blob：头部 + 按 config_keys 顺序紧凑排列的值，以及存在位图
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t length;    // payload 长度，键表变化后不兼容
+    uint16_t reserved2;
+    uint32_t crc;       // payload 的 CRC32
+    struct {
+        uint8_t value[CONFIG_KEY_COUNT];
+        uint8_t present[(CONFIG_KEY_COUNT + 7) / 8];
+    } payload;
+} config_blob_t;
+
+static enclosure_config_t config_shadow;
+static volatile uint32_t config_gen = 0;   // 镜像每次变化时递增，供派生数据判断是否需要重建
+
+static config_key_t config_keys[CONFIG_KEY_COUNT];
+static SemaphoreHandle_t nvs_lock = NULL;
+static esp_timer_handle_t flush_timer = NULL;
+static TaskHandle_t flush_task_handle = NULL;
+static uint8_t dirty_keys[MAX_DIRTY_KEYS];   // config_keys 下标
+static int dirty_count = 0;
+static uint16_t wear_counts[CONFIG_KEY_COUNT];
+static uint32_t total_commits = 0;
+
+// 镜像结构体中与前缀和编号对应的项，不检查该键是否被持久化
+static config_entry_t *shadow_entry(uint8_t gpio_num, const char *prefix) {
+    if (strcmp(prefix, "gpio") == 0) {
+        return gpio_num < GPIO_NUM_MAX ? &config_shadow.gpio[gpio_num] : NULL;
+    }
+    if (strcmp(prefix, "ext_gpio") == 0) {
+        return gpio_num < GPIO_NUM_MAX ? &config_shadow.ext_gpio[gpio_num] : NULL;
+    }
+    if (strcmp(prefix, "spin_prio") == 0) {
+        return gpio_num < GPIO_NUM_MAX ? &config_shadow.spin_prio[gpio_num] : NULL;
+    }
+    if (strcmp(prefix, "debounce") == 0) {
+        return gpio_num < GPIO_NUM_MAX ? &config_shadow.debounce[gpio_num] : NULL;
+    }
+    if (gpio_num != 0x00) {
+        return NULL;
+    }
+    if (strcmp(prefix, "enclosure_mode") == 0) {
+        return &config_shadow.enclosure_mode;
+    }
+    if (strcmp(prefix, "sata_onpower") == 0) {
+        return &config_shadow.sata_onpower;
+    }
+    if (strcmp(prefix, "susp_en") == 0) {
+        return &config_shadow.susp_en;
+    }
+    if (strcmp(prefix, "ususp_en") == 0) {
+        return &config_shadow.ususp_en;
+    }
+    if (strcmp(prefix, "ext_restart") == 0) {
+        return &config_shadow.ext_restart;
+    }
+    if (strcmp(prefix, "spin_max") == 0) {
+        return &config_shadow.spin_max;
+    }
+    if (strcmp(prefix, "spin_gap") == 0) {
+        return &config_shadow.spin_gap;
+    }
+    if (strcmp(prefix, "spin_time") == 0) {
+        return &config_shadow.spin_time;
+    }
+    if (strcmp(prefix, "hid_prof") == 0) {
+        return &config_shadow.hid_prof;
+    }
+    return NULL;
+}
+
+static int add_keys(int pos, const char *prefix, const uint8_t *pins, int count) {
+    for (int i = 0; i < count; i++) {
+        config_keys[pos].prefix = prefix;
+        config_keys[pos].gpio_num = pins[i];
+        config_keys[pos].entry = shadow_entry(pins[i], prefix);
+        pos++;
+    }
+    return pos;
+}
+
+static void build_config_keys(void) {
+    static const uint8_t zero = 0;
+    int pos = 0;
+    pos = add_keys(pos, "gpio", switch_pins, sizeof(switch_pins));
+    pos = add_keys(pos, "ext_gpio", switch_pins, sizeof(switch_pins));
+    pos = add_keys(pos, "debounce", irq_pins, sizeof(irq_pins));
+    pos = add_keys(pos, "spin_prio", slot_pins, sizeof(slot_pins));
+    for (int i = 0; i < sizeof(scalar_keys) / sizeof(scalar_keys[0]); i++) {
+        pos = add_keys(pos, scalar_keys[i], &zero, 1);
+    }
+}
+
+// 持久化键在 config_keys 中的下标，未被镜像的键返回 -1
+static int config_index(uint8_t gpio_num, const char *prefix) {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (config_keys[i].gpio_num == gpio_num && strcmp(config_keys[i].prefix, prefix) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static config_entry_t *config_entry(uint8_t gpio_num, const char *prefix) {
+    int index = config_index(gpio_num, prefix);
+    return index >= 0 ? config_keys[index].entry : NULL;
+}
+
+static void load_entry(nvs_handle_t nvs_handle, config_entry_t *entry, const char *prefix, uint8_t gpio_num) {
+    // 与 save_state() 相同的 16 字节键缓冲，保证读写使用同一个（可能被截断的）键名
+    char key[16];
+    snprintf(key, sizeof(key), "%s_%d", prefix, gpio_num);
+    entry->present = (nvs_get_u8(nvs_handle, key, &entry->value) == ESP_OK);
+    if (!entry->present) {
+        entry->value = 0;
+    }
+}
+
+// 旧版布局：每个配置项一个 "%s_%d" u8 键
+static void load_legacy_config(nvs_handle_t nvs_handle) {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        load_entry(nvs_handle, config_keys[i].entry, config_keys[i].prefix, config_keys[i].gpio_num);
+    }
+}
+
+static bool load_config_blob(nvs_handle_t nvs_handle) {
+    static config_blob_t blob;
+    size_t len = sizeof(blob);
+
+    esp_err_t err = nvs_get_blob(nvs_handle, CONFIG_BLOB_KEY, &blob, &len);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return false;
+    }
+    if (err != ESP_OK || len != sizeof(blob) || blob.magic != CONFIG_BLOB_MAGIC) {
+        ESP_LOGW(TAG, "Config blob unreadable (%s, %d bytes)", esp_err_to_name(err), (int)len);
+        return false;
+    }
+    if (blob.version != CONFIG_BLOB_VERSION || blob.length != sizeof(blob.payload)) {
+        ESP_LOGW(TAG, "Config blob v%d/%d bytes not supported", blob.version, blob.length);
+        return false;
+    }
+    if (esp_crc32_le(0, (const uint8_t *)&blob.payload, sizeof(blob.payload)) != blob.crc) {
+        ESP_LOGE(TAG, "Config blob CRC mismatch");
+        return false;
+    }
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        config_keys[i].entry->value = blob.payload.value[i];
+        config_keys[i].entry->present = (blob.payload.present[i / 8] >> (i % 8)) & 0x01;
+    }
+    return true;
+}
+
+// 调用时必须持有 nvs_lock（或处于 init 阶段）
+static esp_err_t write_config_blob(nvs_handle_t nvs_handle) {
+    static config_blob_t blob;
+
+    memset(&blob, 0, sizeof(blob));
+    blob.magic = CONFIG_BLOB_MAGIC;
+    blob.version = CONFIG_BLOB_VERSION;
+    blob.length = sizeof(blob.payload);
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        blob.payload.value[i] = config_keys[i].entry->value;
+        if (config_keys[i].entry->present) {
+            blob.payload.present[i / 8] |= 1 << (i % 8);
+        }
+    }
+    blob.crc = esp_crc32_le(0, (const uint8_t *)&blob.payload, sizeof(blob.payload));
+    return nvs_set_blob(nvs_handle, CONFIG_BLOB_KEY, &blob, sizeof(blob));
+}
+
+static void load_config_shadow(void) {
+    nvs_handle_t nvs_handle;
+    int64_t start_us = esp_timer_get_time();
+    memset(&config_shadow, 0, sizeof(config_shadow));
+    config_gen++;
+
+    if (nvs_open("storage", NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        ESP_LOGW(TAG, "No storage namespace yet, config shadow empty");
+        return;
+    }
+
+    bool from_blob = load_config_blob(nvs_handle);
+    if (!from_blob) {
+        // 首次启动新固件或 blob 损坏：从旧键迁移并立即写入 blob，旧键保留以便回退固件
+        memset(&config_shadow, 0, sizeof(config_shadow));
+        load_legacy_config(nvs_handle);
+        if (write_config_blob(nvs_handle) == ESP_OK && nvs_commit(nvs_handle) == ESP_OK) {
+            ESP_LOGI(TAG, "Migrated legacy keys to config blob v%d", CONFIG_BLOB_VERSION);
+        } else {
+            ESP_LOGE(TAG, "Failed to write config blob");
+        }
+    }
+
+    size_t wear_len = sizeof(wear_counts);
+    if (nvs_get_blob(nvs_handle, "wear_cnt", wear_counts, &wear_len) != ESP_OK || wear_len != sizeof(wear_counts)) {
+        memset(wear_counts, 0, sizeof(wear_counts));
+    }
+    nvs_get_u32(nvs_handle, "commit_cnt", &total_commits);
+    nvs_close(nvs_handle);
+    ESP_LOGI(TAG, "Config shadow loaded from %s in %ld us", from_blob ? "blob" : "legacy keys",
+             (long)(esp_timer_get_time() - start_us));
+}
+
+esp_err_t read_nvs_state(uint8_t gpio_num, const char *prefix, uint8_t *value) {
+    config_entry_t *entry = config_entry(gpio_num, prefix);
+    if (entry != NULL) {
+        *value = entry->value;
+        return entry->present ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // 未镜像的键（例如非零编号的全局项）仍直接读取 NVS
     nvs_handle_t nvs_handle;
-    uint8_t value = 0;
     char key[16];
     snprintf(key, sizeof(key), "%s_%d", prefix, gpio_num);
 
+    *value = 0;
     esp_err_t ret = nvs_open("storage", NVS_READONLY, &nvs_handle);
     if (ret == ESP_OK) {
-        if (nvs_get_u8(nvs_handle, key, &value) != ESP_OK) {
-            value = 0;
+        ret = nvs_get_u8(nvs_handle, key, value);
+        if (ret != ESP_OK) {
+            *value = 0;
         }
         nvs_close(nvs_handle);
     }
+    return ret;
+}
+
+uint8_t get_nvs_state(uint8_t gpio_num, const char *prefix) {
+    uint8_t value = 0;
+    read_nvs_state(gpio_num, prefix, &value);
     return value;
 }
 
+const enclosure_config_t *get_config(void) {
+    return &config_shadow;
+}
+
+// 持有期间镜像与 config_generation() 不会被 save_state()/clear_nvs_all() 修改；不可在持有期间调用 save_state()
+void config_lock(void) {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+}
+
+void config_unlock(void) {
+    xSemaphoreGive(nvs_lock);
+}
+
+uint32_t config_generation(void) {
+    return config_gen;
+}
+
+// 写入合并：save_state() 只更新镜像并记入脏表，由定时器或显式 flush 把整个配置 blob 一次写入 NVS
+// 定时器回调只唤醒低优先级的提交任务，flash 擦写不阻塞其他 esp_timer 回调（例如上电时序器）
+static void flush_timer_cb(void *arg) {
+    xTaskNotifyGive(flush_task_handle);
+}
+
+static void nvs_flush_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        nvs_flush_state(false);
+    }
+}
+
 void init_nvs() {
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         nvs_flash_erase();
         nvs_flash_init();
     }
+
+    nvs_lock = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(nvs_lock != NULL ? ESP_OK : ESP_ERR_NO_MEM);
+    const esp_timer_create_args_t args = {
+        .callback = flush_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "nvs_flush",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &flush_timer));
+    ESP_ERROR_CHECK(xTaskCreate(nvs_flush_task, "nvs_flush", 3072, NULL, tskIDLE_PRIORITY + 1, &flush_task_handle) == pdPASS
+                    ? ESP_OK : ESP_ERR_NO_MEM);
+
+    build_config_keys();
+    load_config_shadow();
 }
 
-void save_state(uint8_t gpio_num, uint8_t value, const char *prefix) {
+static int dirty_index(int index) {
+    for (int i = 0; i < dirty_count; i++) {
+        if (dirty_keys[i] == index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 调用时必须持有 nvs_lock
+static void flush_locked(bool save_wear) {
     nvs_handle_t nvs_handle;
-    char key[16];
-    snprintf(key, sizeof(key), "%s_%d", prefix, gpio_num);
 
-    ESP_LOGI(TAG, "Saving value %d for %s_%d", value, prefix, gpio_num);
+    if (dirty_count > 0 && nvs_open("storage", NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        if (write_config_blob(nvs_handle) == ESP_OK && nvs_commit(nvs_handle) == ESP_OK) {
+            for (int i = 0; i < dirty_count; i++) {
+                wear_counts[dirty_keys[i]]++;
+            }
+            ESP_LOGI(TAG, "Committed %d key/s", dirty_count);
+            dirty_count = 0;
+            total_commits++;
+            save_wear |= (total_commits % WEAR_SAVE_EVERY) == 0;
+        } else {
+            ESP_LOGE(TAG, "NVS commit failed, keeping %d dirty key/s", dirty_count);
+        }
+        nvs_close(nvs_handle);
+    }
 
-    if (nvs_open("storage", NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        nvs_set_u8(nvs_handle, key, value);
+    if (save_wear && nvs_open("storage", NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        nvs_set_blob(nvs_handle, "wear_cnt", wear_counts, sizeof(wear_counts));
+        nvs_set_u32(nvs_handle, "commit_cnt", total_commits);
         nvs_commit(nvs_handle);
         nvs_close(nvs_handle);
     }
 }
 
+void nvs_flush_state(bool save_wear) {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    esp_timer_stop(flush_timer);
+    flush_locked(save_wear);
+    xSemaphoreGive(nvs_lock);
+}
 
-uint8_t enclosure_mode_selected() {
-    nvs_handle_t nvs_handle;
-    uint8_t value = 0;
-    char key[17];
-    snprintf(key, sizeof(key), "enclosure_mode_0");
+static void save_state_locked(uint8_t gpio_num, uint8_t value, const char *prefix) {
+    int index = config_index(gpio_num, prefix);
 
-    esp_err_t ret = nvs_open("storage", NVS_READONLY, &nvs_handle);
-    if (ret == ESP_OK) {
-        if (nvs_get_u8(nvs_handle, key, &value) == ESP_OK) {
-            return value;
-        } else {
-            save_state(0x00, 0, "enclosure_mode");
-            return 0x00;
+    if (index < 0) {
+        // 未镜像的键直接写入
+        nvs_handle_t nvs_handle;
+        char key[16];
+        snprintf(key, sizeof(key), "%s_%d", prefix, gpio_num);
+        ESP_LOGI(TAG, "Saving value %d for %s_%d", value, prefix, gpio_num);
+        if (nvs_open("storage", NVS_READWRITE, &nvs_handle) == ESP_OK) {
+            if (nvs_set_u8(nvs_handle, key, value) == ESP_OK) {
+                nvs_commit(nvs_handle);
+            }
+            nvs_close(nvs_handle);
         }
-        nvs_close(nvs_handle);
-    } else {
-        save_state(0x00, 0, "enclosure_mode");
-        return 0x00;
+        return;
+    }
+
+    config_entry_t *entry = config_keys[index].entry;
+    if (entry->present && entry->value == value) {
+        ESP_LOGD(TAG, "Skip unchanged %s_%d", prefix, gpio_num);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Saving value %d for %s_%d", value, prefix, gpio_num);
+    entry->value = value;
+    entry->present = 1;
+    config_gen++;
+
+    if (dirty_index(index) < 0) {
+        if (dirty_count == MAX_DIRTY_KEYS) {
+            flush_locked(false);
+        }
+        dirty_keys[dirty_count++] = index;
+    }
+    if (!esp_timer_is_active(flush_timer)) {
+        esp_timer_start_once(flush_timer, NVS_FLUSH_DELAY_MS * 1000);
+    }
+}
+
+void save_state(uint8_t gpio_num, uint8_t value, const char *prefix) {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    save_state_locked(gpio_num, value, prefix);
+    xSemaphoreGive(nvs_lock);
+}
+
+// 多个同前缀的值进入同一批脏数据，随后一次提交
+void save_state_batch(const uint8_t *gpio_nums, const uint8_t *values, int count, const char *prefix) {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    for (int i = 0; i < count; i++) {
+        save_state_locked(gpio_nums[i], values[i], prefix);
+    }
+    xSemaphoreGive(nvs_lock);
+}
+
+// 读取某个键的累计提交次数；键名形如 "gpio_34"
+esp_err_t nvs_wear_count(const char *key, uint32_t *count, uint32_t *commits) {
+    const char *sep = strrchr(key, '_');
+    char prefix[16];
+
+    *commits = total_commits;
+    if (sep == NULL || sep == key || sep - key >= sizeof(prefix)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(prefix, key, sep - key);
+    prefix[sep - key] = '\0';
+    int index = config_index(atoi(sep + 1), prefix);
+    if (index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *count = wear_counts[index];
+    return ESP_OK;
+}
+
+uint8_t enclosure_mode_selected() {
+    if (config_shadow.enclosure_mode.present) {
+        return config_shadow.enclosure_mode.value;
     }
+    save_state(0x00, 0, "enclosure_mode");
+    return 0x00;
 }
 
 void clear_nvs_all() {
     esp_err_t err;
+    // 持锁并停止定时提交，避免擦除过程中或擦除后立即写回旧的 blob
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    esp_timer_stop(flush_timer);
+    dirty_count = 0;
     err = nvs_flash_erase();
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "NVS erased successfully.");
@@ -77,4 +473,6 @@ void clear_nvs_all() {
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "NVS re-initialized.");
     }
+    load_config_shadow();
+    xSemaphoreGive(nvs_lock);
 }
\ No newline at end of file
@@ -2,10 +2,43 @@
 #define NVS_HANDLE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef struct {
+    uint8_t value;
+    uint8_t present;
+} config_entry_t;
+
+// NVS "storage" 命名空间在 RAM 中的镜像，init_nvs() 时加载一次
+typedef struct {
+    config_entry_t gpio[GPIO_NUM_MAX];
+    config_entry_t ext_gpio[GPIO_NUM_MAX];
+    config_entry_t enclosure_mode;
+    config_entry_t sata_onpower;
+    config_entry_t susp_en;
+    config_entry_t ususp_en;
+    config_entry_t ext_restart;
+    config_entry_t spin_max;
+    config_entry_t spin_gap;
+    config_entry_t spin_time;
+    config_entry_t hid_prof;
+    config_entry_t spin_prio[GPIO_NUM_MAX];
+    config_entry_t debounce[GPIO_NUM_MAX];
+} enclosure_config_t;
 
 uint8_t get_nvs_state(uint8_t gpio_num, const char *prefix);
+esp_err_t read_nvs_state(uint8_t gpio_num, const char *prefix, uint8_t *value);
 void init_nvs();
 void save_state(uint8_t gpio_num, uint8_t value, const char *prefix);
+void save_state_batch(const uint8_t *gpio_nums, const uint8_t *values, int count, const char *prefix);
+void nvs_flush_state(bool save_wear);
+esp_err_t nvs_wear_count(const char *key, uint32_t *count, uint32_t *commits);
 uint8_t enclosure_mode_selected();
+const enclosure_config_t *get_config(void);
+void config_lock(void);
+void config_unlock(void);
+uint32_t config_generation(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <sys/param.h>
+#include "power_sched.h"
+
+// 推进等待中的槽位并按上电策略选出下一个可上电的槽位：等待结束的槽位进入队列，
+// 满足间隔与并发上限时返回优先级最高的队列槽位下标，否则返回 -1。
+// *next_us 为下一次需要重新判定的时间，INT64_MAX 表示无需唤醒。
+// 调用者上电所选槽位后应更新 state/ready_us/last_enable_us 并再次调用，直到返回 -1
+int power_sched_pick(power_sched_slot_t slots[POWER_SEQ_SLOT_COUNT], const power_seq_policy_t *policy,
+                     int64_t last_enable_us, int64_t now, int64_t *next_us) {
+    int64_t gap_us = (int64_t)policy->gap_10ms * 10000;
+    int64_t spin_us = (int64_t)policy->spin_100ms * 100000;
+    int pick = -1;
+
+    *next_us = INT64_MAX;
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        if (slots[i].state == POWER_SLOT_WAITING) {
+            if (slots[i].deadline_us <= now) {
+                slots[i].state = POWER_SLOT_QUEUED;
+            } else if (slots[i].deadline_us < *next_us) {
+                *next_us = slots[i].deadline_us;
+            }
+        }
+    }
+
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        if (slots[i].state != POWER_SLOT_QUEUED) {
+            continue;
+        }
+        if (pick < 0 || policy->priority[i] < policy->priority[pick]) {
+            pick = i;
+        }
+    }
+    if (pick < 0) {
+        return -1;
+    }
+
+    int active = 0;
+    int64_t window_end_us = INT64_MAX;
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        int64_t end = slots[i].ready_us + spin_us;
+        if (slots[i].state == POWER_SLOT_ON && end > now) {
+            active++;
+            if (end < window_end_us) {
+                window_end_us = end;
+            }
+        }
+    }
+
+    if (now < last_enable_us + gap_us) {
+        *next_us = MIN(*next_us, last_enable_us + gap_us);
+        return -1;
+    }
+    if (policy->max_active != 0 && active >= policy->max_active) {
+        *next_us = MIN(*next_us, window_end_us);
+        return -1;
+    }
+    return pick;
+}
+
+// 把一个延迟样本计入直方图与 min/max；调用者负责加锁
+void rail_latency_record(rail_latency_t *lat, uint32_t us) {
+    int bucket = 0;
+    while (bucket < RAIL_LAT_BUCKETS - 1 && us >= ((uint32_t)RAIL_LAT_BUCKET0_US << bucket)) {
+        bucket++;
+    }
+    lat->buckets[bucket]++;
+    if (lat->count == 0 || us < lat->min_us) {
+        lat->min_us = us;
+    }
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+    lat->count++;
+}
+
+// 由直方图估算百分位：返回累计达到 permille 的桶上限，落在最后一桶时返回 max
+uint32_t rail_latency_percentile(const rail_latency_t *lat, uint32_t permille) {
+    if (lat->count == 0) {
+        return 0;
+    }
+    uint64_t target = ((uint64_t)lat->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int i = 0; i < RAIL_LAT_BUCKETS - 1; i++) {
+        seen += lat->buckets[i];
+        if (seen >= target) {
+            uint32_t upper = (uint32_t)RAIL_LAT_BUCKET0_US << i;
+            return upper < lat->max_us ? upper : lat->max_us;
+        }
+    }
+    return lat->max_us;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef POWER_SCHED_H
+#define POWER_SCHED_H
+
+#include <stdint.h>
+#include "power_seq.h"
+
+// 调度判定只用到的槽位状态，由 power_seq.c 在 seq_lock 下维护
+typedef struct {
+    uint8_t state;
+    int64_t deadline_us;   // WAITING 状态下的最早上电时间
+    int64_t ready_us;      // 最近一次上电时间，起转窗口从此开始
+} power_sched_slot_t;
+
+int power_sched_pick(power_sched_slot_t slots[POWER_SEQ_SLOT_COUNT], const power_seq_policy_t *policy,
+                     int64_t last_enable_us, int64_t now, int64_t *next_us);
+void rail_latency_record(rail_latency_t *lat, uint32_t us);
+uint32_t rail_latency_percentile(const rail_latency_t *lat, uint32_t permille);
+
+#endif
\ No newline at end of file
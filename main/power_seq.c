@@ -0,0 +1,242 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "power_seq.h"
+#include "power_sched.h"
+#include "nvs_handle.h"
+#include "state_push.h"
+
+static const char *TAG = "Power Sequencer";
+
+typedef struct {
+    gpio_num_t gpio_num;
+    const char *name;
+    power_sched_slot_t sched;
+    int64_t requested_us;
+    int64_t edge_us;      // 等待写入的 HDDPC 边沿时间戳，0 表示无
+    uint8_t edge_level;
+} power_slot_t;
+
+static power_slot_t slots[POWER_SEQ_SLOT_COUNT] = {
+    { .gpio_num = GPIO_NUM_34, .name = "SATA1" },
+    { .gpio_num = GPIO_NUM_38, .name = "SATA2" },
+    { .gpio_num = GPIO_NUM_45, .name = "NVMe" },
+};
+
+static power_seq_policy_t policy;
+static int64_t last_enable_us = INT64_MIN / 2;
+static esp_timer_handle_t seq_timer = NULL;
+static SemaphoreHandle_t seq_lock = NULL;
+static rail_latency_t rail_latency[POWER_SEQ_SLOT_COUNT][2];
+
+static power_slot_t *find_slot(uint8_t gpio_num) {
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        if (slots[i].gpio_num == gpio_num) {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+bool power_seq_is_slot(uint8_t gpio_num) {
+    return find_slot(gpio_num) != NULL;
+}
+
+// 槽位 GPIO 被写为 level 后调用；若有同方向的待处理边沿则记录延迟。调用时必须持有 seq_lock
+static void note_rail_write(power_slot_t *slot, uint8_t level, int64_t now) {
+    if (slot->edge_us == 0 || slot->edge_level != level) {
+        return;
+    }
+    rail_latency_record(&rail_latency[slot - slots][level ? 1 : 0], (uint32_t)(now - slot->edge_us));
+    slot->edge_us = 0;
+}
+
+static void enable_slot(power_slot_t *slot, int64_t now) {
+    gpio_set_level(slot->gpio_num, 1);
+    note_rail_write(slot, 1, now);
+    slot->sched.state = POWER_SLOT_ON;
+    slot->sched.ready_us = now;
+    last_enable_us = now;
+    ESP_LOGI(TAG, "%s (GPIO %d) powered up after %ld ms", slot->name, slot->gpio_num,
+             (long)((now - slot->requested_us) / 1000));
+    state_push_notify();
+}
+
+// 推进状态机：按 power_sched_pick() 的判定依次上电，并安排下一次唤醒。
+// 调用时必须持有 seq_lock
+static void schedule_locked(void) {
+    power_sched_slot_t sched[POWER_SEQ_SLOT_COUNT];
+    int64_t now = esp_timer_get_time();
+    int64_t next_us;
+    int pick;
+
+    // 在副本上判定，判定过程中进入队列的槽位在结束时写回
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        sched[i] = slots[i].sched;
+    }
+    while ((pick = power_sched_pick(sched, &policy, last_enable_us, now, &next_us)) >= 0) {
+        enable_slot(&slots[pick], now);
+        sched[pick] = slots[pick].sched;
+    }
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        slots[i].sched = sched[i];
+    }
+
+    esp_timer_stop(seq_timer);
+    if (next_us != INT64_MAX) {
+        int64_t wait_us = next_us - now;
+        esp_timer_start_once(seq_timer, wait_us > 0 ? (uint64_t)wait_us : 1);
+    }
+}
+
+static void power_seq_timer_cb(void *arg) {
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    schedule_locked();
+    xSemaphoreGive(seq_lock);
+}
+
+static void load_policy(void) {
+    policy.max_active = get_nvs_state(0x00, "spin_max");
+    policy.gap_10ms = get_nvs_state(0x00, "spin_gap");
+    policy.spin_100ms = get_nvs_state(0x00, "spin_time");
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        policy.priority[i] = get_nvs_state(slots[i].gpio_num, "spin_prio");
+    }
+}
+
+void power_seq_init(void) {
+    seq_lock = xSemaphoreCreateMutex();
+    load_policy();
+    const esp_timer_create_args_t args = {
+        .callback = power_seq_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "power_seq",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &seq_timer));
+}
+
+// 为指定 GPIO 设定目标电平；上电请求在 delay_ms 之后按上电策略执行，不阻塞调用者
+void power_seq_request(uint8_t gpio_num, uint8_t level, uint32_t delay_ms) {
+    power_slot_t *slot = find_slot(gpio_num);
+    if (slot == NULL) {
+        gpio_set_level(gpio_num, level);
+        state_push_notify();
+        return;
+    }
+
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    if (level == 0) {
+        gpio_set_level(slot->gpio_num, 0);
+        note_rail_write(slot, 0, now);
+        slot->sched.state = POWER_SLOT_OFF;
+        state_push_notify();
+    } else if (slot->sched.state == POWER_SLOT_WAITING || slot->sched.state == POWER_SLOT_QUEUED) {
+        // 已在等待上电，保持原截止时间
+    } else if (gpio_get_level(slot->gpio_num) == 1) {
+        slot->sched.state = POWER_SLOT_ON;
+    } else {
+        slot->sched.state = POWER_SLOT_WAITING;
+        slot->requested_us = now;
+        slot->sched.deadline_us = now + (int64_t)delay_ms * 1000;
+        if (delay_ms > 0) {
+            ESP_LOGI(TAG, "%s (GPIO %d) power-up scheduled in %lu ms", slot->name, slot->gpio_num, (unsigned long)delay_ms);
+        }
+    }
+    schedule_locked();
+    xSemaphoreGive(seq_lock);
+}
+
+// 引脚已被外部（端口寄存器批量写入）驱动到 level，只同步槽位状态并取消待执行的上电
+void power_seq_note_level(uint8_t gpio_num, uint8_t level) {
+    power_slot_t *slot = find_slot(gpio_num);
+    if (slot == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    note_rail_write(slot, level, esp_timer_get_time());
+    state_push_notify();
+    if (level == 0) {
+        slot->sched.state = POWER_SLOT_OFF;
+    } else if (slot->sched.state != POWER_SLOT_ON) {
+        int64_t now = esp_timer_get_time();
+        slot->sched.state = POWER_SLOT_ON;
+        slot->requested_us = now;
+        slot->sched.ready_us = now;
+        last_enable_us = now;
+    }
+    schedule_locked();
+    xSemaphoreGive(seq_lock);
+}
+
+void power_seq_get_status(power_slot_status_t status[POWER_SEQ_SLOT_COUNT]) {
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        status[i].gpio_num = slots[i].gpio_num;
+        status[i].state = slots[i].sched.state;
+        status[i].remaining_ms = 0;
+        status[i].ready_after_ms = 0;
+        if (slots[i].sched.state == POWER_SLOT_WAITING && slots[i].sched.deadline_us > now) {
+            status[i].remaining_ms = (uint32_t)((slots[i].sched.deadline_us - now) / 1000);
+        } else if (slots[i].sched.state == POWER_SLOT_ON) {
+            status[i].ready_after_ms = (uint32_t)((slots[i].sched.ready_us - slots[i].requested_us) / 1000);
+        }
+    }
+    xSemaphoreGive(seq_lock);
+}
+
+void power_seq_get_policy(power_seq_policy_t *out) {
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    *out = policy;
+    xSemaphoreGive(seq_lock);
+}
+
+void power_seq_set_policy(const power_seq_policy_t *new_policy) {
+    save_state(0x00, new_policy->max_active, "spin_max");
+    save_state(0x00, new_policy->gap_10ms, "spin_gap");
+    save_state(0x00, new_policy->spin_100ms, "spin_time");
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        save_state(slots[i].gpio_num, new_policy->priority[i], "spin_prio");
+    }
+
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    policy = *new_policy;
+    schedule_locked();
+    xSemaphoreGive(seq_lock);
+}
+
+// HDDPC 回调在请求供电轨变化之前调用，edge_us 为触发该变化的边沿在 ISR 中的时间戳
+void power_seq_note_edge(uint8_t gpio_num, uint8_t level, int64_t edge_us) {
+    power_slot_t *slot = find_slot(gpio_num);
+    if (slot == NULL) {
+        return;
+    }
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    if (slot->edge_us != 0) {
+        rail_latency[slot - slots][slot->edge_level ? 1 : 0].unserved++;
+    }
+    slot->edge_us = edge_us;
+    slot->edge_level = level;
+    xSemaphoreGive(seq_lock);
+}
+
+bool power_seq_get_latency(int slot, uint8_t level, rail_latency_t *out) {
+    if (slot < 0 || slot >= POWER_SEQ_SLOT_COUNT) {
+        return false;
+    }
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    *out = rail_latency[slot][level ? 1 : 0];
+    xSemaphoreGive(seq_lock);
+    return true;
+}
+
+void power_seq_reset_latency(void) {
+    xSemaphoreTake(seq_lock, portMAX_DELAY);
+    memset(rail_latency, 0, sizeof(rail_latency));
+    xSemaphoreGive(seq_lock);
+}
\ No newline at end of file
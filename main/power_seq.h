@@ -0,0 +1,58 @@
+#ifndef POWER_SEQ_H
+#define POWER_SEQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POWER_SEQ_SLOT_COUNT 3
+// 槽位引脚：SATA1 GPIO34, SATA2 GPIO38, NVMe GPIO45，需与 power_seq.c 中的 slots 一致
+#define POWER_SEQ_SLOT_MASK  ((1ULL << 34) | (1ULL << 38) | (1ULL << 45))
+
+typedef enum {
+    POWER_SLOT_OFF = 0,
+    POWER_SLOT_WAITING,
+    POWER_SLOT_ON,
+    POWER_SLOT_QUEUED,
+} power_slot_state_t;
+
+typedef struct {
+    uint8_t gpio_num;
+    uint8_t state;
+    uint32_t remaining_ms;
+    uint32_t ready_after_ms;
+} power_slot_status_t;
+
+// 上电策略：max_active 为同时处于起转窗口的槽位上限(0 表示不限)，
+// gap 为两次上电之间的最小间隔(10 ms)，spin_time 为单个槽位的起转窗口(100 ms)，
+// priority 数值越小越先上电
+typedef struct {
+    uint8_t max_active;
+    uint8_t gap_10ms;
+    uint8_t spin_100ms;
+    uint8_t priority[POWER_SEQ_SLOT_COUNT];
+} power_seq_policy_t;
+
+#define RAIL_LAT_BUCKETS    16
+#define RAIL_LAT_BUCKET0_US 64    // 第 i 桶上限为 64us << i，最后一桶不设上限
+
+// HDDPC 边沿(ISR 时间戳)到供电轨 GPIO 写入的延迟，按槽位和方向分别统计
+typedef struct {
+    uint32_t buckets[RAIL_LAT_BUCKETS];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t unserved;    // 未写入 GPIO 就被下一个边沿覆盖的请求数
+} rail_latency_t;
+
+void power_seq_init(void);
+bool power_seq_is_slot(uint8_t gpio_num);
+void power_seq_request(uint8_t gpio_num, uint8_t level, uint32_t delay_ms);
+void power_seq_note_level(uint8_t gpio_num, uint8_t level);
+void power_seq_get_status(power_slot_status_t status[POWER_SEQ_SLOT_COUNT]);
+void power_seq_get_policy(power_seq_policy_t *policy);
+void power_seq_set_policy(const power_seq_policy_t *policy);
+void power_seq_note_edge(uint8_t gpio_num, uint8_t level, int64_t edge_us);
+bool power_seq_get_latency(int slot, uint8_t level, rail_latency_t *out);
+void power_seq_reset_latency(void);
+
+#endif
\ No newline at end of file
@@ -3,7 +3,6 @@
 #include "nvs_handle.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
-#include <psa/crypto.h>
 #include <string.h>
 #include "class/hid/hid_device.h"
 #include "esp_system.h"
@@ -14,10 +13,23 @@
 #include "esp_rom_gpio.h"
 #include "soc/rtc_cntl_reg.h"
 #include "alive_hid.h"
+#include "hid_auth.h"
+#include "cmd_worker.h"
+#include "power_seq.h"
+#include "power_sched.h"
+#include "irq_queue.h"
+#include "state_push.h"
+#include "event_log.h"
+#include "boot_prof.h"
+#include "usb_health.h"
+#include "hid_profile.h"
+#include "hid_tx.h"
+#include "hid_ota.h"
+#include "vendor_bulk.h"
+#include "esp_timer.h"
 
 static const char *TAG = "R-SODIUM Controller";
 #define REPORT_SIZE 64
-#define HMAC_KEY    "a0HyIvVM6A6Z7dTPYrAk8s3Mpouh"
 
 const char *current_version = "v1.4.4";
 
@@ -27,186 +39,729 @@ void enter_dfu_mode(void)
 {
 
     ESP_LOGW(TAG, "Preparing to enter ROM DFU mode...");
+    nvs_flush_state(true);
     REG_WRITE(RTC_CNTL_OPTION1_REG, RTC_CNTL_FORCE_DOWNLOAD_BOOT);
     vTaskDelay(pdMS_TO_TICKS(1000));
     esp_restart();
 }
 
-void send_hid_response(uint8_t command, const uint8_t *payload, size_t payload_len) {
+// 正在处理的 v2 请求标签，只在 cmd_worker 任务中读写
+static int current_tag = PROTO_NO_TAG;
+
+// tag 为 PROTO_NO_TAG 时使用 v1 格式；可在任意任务中调用。
+// 负载超出所用格式的容量时不截断，改为回复 "OVF"
+void send_hid_reply_tagged(int tag, uint8_t command, const uint8_t *payload, size_t payload_len) {
     uint8_t report[REPORT_SIZE] = {0};
-    uint8_t mac[32];
-    size_t mac_len;
+    uint8_t mac[HID_AUTH_MAC_LEN];
+    size_t capacity = tag == PROTO_NO_TAG ? PROTO_V1_MAX_PAYLOAD : PROTO_V2_MAX_PAYLOAD;
 
-    report[0] = command;
-    memcpy(report + 1, payload, payload_len > 31 ? 31 : payload_len);
+    if (payload_len > capacity) {
+        ESP_LOGE(TAG, "Reply for opcode 0x%02X is %d bytes, %d fit", command, (int)payload_len, (int)capacity);
+        payload = (const uint8_t *)"OVF";
+        payload_len = 3;
+    }
+    if (tag == PROTO_NO_TAG) {
+        report[0] = command;
+        memcpy(report + 1, payload, payload_len);
+    } else {
+        report[0] = PROTO_V2_MARKER;
+        report[1] = (uint8_t)tag;
+        report[2] = command;
+        memcpy(report + PROTO_V2_HEADER, payload, payload_len);
+    }
 
-    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
-    psa_set_key_usage_flags(&attributes, PSA_KEY_USAGE_SIGN_MESSAGE);
-    psa_set_key_algorithm(&attributes, PSA_ALG_HMAC(PSA_ALG_SHA_256));
-    psa_set_key_type(&attributes, PSA_KEY_TYPE_HMAC);
+    if (tag == PROTO_NO_TAG) {
+        hid_auth_sign(report, 32, mac);
+    } else {
+        hid_auth_sign_v2(report, 32, mac);
+    }
+
+    memcpy(report + 32, mac, HID_AUTH_MAC_LEN);
+    cmd_worker_note_reply(report);
+    hid_tx_send(report, HID_TX_REPLY);
+
+    event_log_record(EVT_RESPONSE, command, payload_len > 0 ? payload[0] : 0, (uint8_t)payload_len);
+}
+
+void send_hid_response(uint8_t command, const uint8_t *payload, size_t payload_len) {
+    send_hid_reply_tagged(current_tag, command, payload, payload_len);
+}
 
-    psa_key_id_t hmac_key_id;
-    psa_import_key(&attributes, (const uint8_t *)HMAC_KEY, strlen(HMAC_KEY), &hmac_key_id);
-    psa_mac_compute(hmac_key_id, PSA_ALG_HMAC(PSA_ALG_SHA_256),
-                    report, 32, mac, sizeof(mac), &mac_len);
-    psa_destroy_key(hmac_key_id);
+static void reply_ok(const uint8_t *data) {
+    send_hid_response(data[0], (const uint8_t *)"OK", 2);
+}
 
-    memcpy(report + 32, mac, 32);
-    tud_hid_report(0, report, REPORT_SIZE);
+static void reply_level(const uint8_t *data, uint8_t value) {
+    const char *response = value ? "HIGH" : "LOW";
+    send_hid_response(data[0], (const uint8_t *)response, strlen(response));
+}
 
-    char buf[3 * REPORT_SIZE + 1];
-    char *p = buf;
-    for (int i = 0; i < REPORT_SIZE; i++) {
-        p += sprintf(p, "%02X ", report[i]);
+void cmd_gpio_set(uint8_t cmd, const uint8_t *data) {
+    uint8_t level = data[0];
+    if (data[4] == 0x01) {
+        power_seq_request(cmd, level, 0);
     }
-    *p = '\0';
+    reply_ok(data);
+    if (data[1] == 0x01) {
+        save_state(cmd, level, "gpio");
+    }
+}
 
-        ESP_LOGI(TAG, "Sent response for cmd 0x%02X: %s", command, buf);
+void cmd_gpio_saved(uint8_t cmd, const uint8_t *data) {
+    // 查询NVS存储的GPIO状态
+    reply_level(data, get_nvs_state(cmd, "gpio"));
+}
+
+void cmd_gpio_live(uint8_t cmd, const uint8_t *data) {
+    // 查询当前的GPIO状态
+    int gpio_level = gpio_get_level(cmd);
+    ESP_LOGD(TAG, "GPIO %d level: %d", cmd, gpio_level);
+    reply_level(data, gpio_level);
+}
+
+void cmd_enclosure_get(uint8_t cmd, const uint8_t *data) {
+    // 查询NVS存储的硬盘盒状态
+    uint8_t enclosure_status = enclosure_mode_selected();
+    send_hid_response(data[0], &enclosure_status, 1);
+}
+
+void cmd_enclosure_set(uint8_t cmd, const uint8_t *data) {
+    // 硬盘盒模式存储
+    save_state(0x00, cmd, "enclosure_mode");
+    reply_ok(data);
+}
+
+void cmd_ext_gpio_set(uint8_t cmd, const uint8_t *data) {
+    // 存储高电平时的GPIO状态
+    save_state(cmd, data[3], "ext_gpio");
+    reply_ok(data);
+}
+
+void cmd_ext_gpio_get(uint8_t cmd, const uint8_t *data) {
+    // 查询NVS存储的EXT GPIO状态
+    reply_level(data, get_nvs_state(cmd, "ext_gpio"));
+}
+
+void cmd_onpower_set(uint8_t cmd, const uint8_t *data) {
+    // 存储SATA上电时间
+    save_state(0x00, cmd, "sata_onpower");
+    reply_ok(data);
+}
+
+void cmd_onpower_get(uint8_t cmd, const uint8_t *data) {
+    // 向主机端返回SATA上电时间
+    uint8_t sata_onpower_time = get_nvs_state(cmd, "sata_onpower");
+    send_hid_response(data[0], &sata_onpower_time, 1);
+}
+
+void cmd_susp_set(uint8_t cmd, const uint8_t *data) {
+    // 是否开启主机端休眠
+    save_state(0x00, cmd, "susp_en");
+    reply_ok(data);
+}
+
+void cmd_susp_get(uint8_t cmd, const uint8_t *data) {
+    // 向主机端返回主机端休眠状态
+    reply_level(data, get_nvs_state(cmd, "susp_en"));
+}
+
+void cmd_ususp_set(uint8_t cmd, const uint8_t *data) {
+    // 是否开启卸载休眠
+    save_state(0x00, cmd, "ususp_en");
+    reply_ok(data);
+}
+
+void cmd_ususp_get(uint8_t cmd, const uint8_t *data) {
+    // 向主机端返回卸载休眠状态
+    reply_level(data, get_nvs_state(0x00, "ususp_en"));
+}
+
+void cmd_power_summary(uint8_t cmd, const uint8_t *data) {
+    // 集体返回供电GPIO的状态
+    uint8_t payload[4] = {
+        get_nvs_state(0x2D, "gpio"),
+        get_nvs_state(0x22, "gpio"),
+        get_nvs_state(0x26, "gpio"),
+        gpio_get_level(0x01)
+    };
+    send_hid_response(0x00, payload, sizeof(payload));
+}
+
+void cmd_ext_restart_set(uint8_t cmd, const uint8_t *data) {
+    // 当外置供电插入时是否重启（保存值）
+    save_state(0x00, cmd, "ext_restart");
+    reply_ok(data);
+}
+
+void cmd_worker_stats(uint8_t cmd, const uint8_t *data) {
+    // 返回命令队列统计：接收/执行/溢出/HMAC失败次数与回调最长耗时(us)
+    cmd_worker_stats_t stats;
+    cmd_worker_get_stats(&stats);
+    uint8_t stats_payload[20];
+    memcpy(stats_payload, &stats.received, 4);
+    memcpy(stats_payload + 4, &stats.processed, 4);
+    memcpy(stats_payload + 8, &stats.overflow, 4);
+    memcpy(stats_payload + 12, &stats.auth_fail, 4);
+    memcpy(stats_payload + 16, &stats.cb_max_us, 4);
+    send_hid_response(data[0], stats_payload, sizeof(stats_payload));
+}
+
+void cmd_power_seq_status(uint8_t cmd, const uint8_t *data) {
+    // 返回各硬盘槽位上电进度：GPIO、状态、剩余等待(ms, u16)、实际就绪耗时(ms, u16)，超过 65535 时取 65535
+    power_slot_status_t slot_status[POWER_SEQ_SLOT_COUNT];
+    power_seq_get_status(slot_status);
+    uint8_t seq_payload[POWER_SEQ_SLOT_COUNT * 6];
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        uint8_t *p = seq_payload + i * 6;
+        uint16_t remaining16 = slot_status[i].remaining_ms > 0xFFFF ? 0xFFFF : slot_status[i].remaining_ms;
+        uint16_t ready16 = slot_status[i].ready_after_ms > 0xFFFF ? 0xFFFF : slot_status[i].ready_after_ms;
+        p[0] = slot_status[i].gpio_num;
+        p[1] = slot_status[i].state;
+        memcpy(p + 2, &remaining16, 2);
+        memcpy(p + 4, &ready16, 2);
     }
+    send_hid_response(data[0], seq_payload, sizeof(seq_payload));
+}
 
-void process_command(uint8_t cmd, const uint8_t *data) {
-    // uint8_t ota_value = get_nvs_state(0x00,"ota_update");
-    // if (ota_value == 0x01) {
-    //     ESP_LOGW(TAG, "Starting OTA Updater");
-    //     hid_packet_t pkt;
-    //     pkt.command = cmd;
-    //     pkt.seq = data[0];
-    //     pkt.length = (cmd==0x00) ? 4 : 29;
-    //     memcpy(pkt.data, data + 1, pkt.length);
-    //     xQueueSend(hid_queue, &pkt, 0);
-    //     return;
-    // }
-    ESP_LOGI(TAG, "Original data: %d %02X %02X %02X %02X %02X", cmd, data[0], data[1], data[2], data[3], data[4]);
+void cmd_policy_set(uint8_t cmd, const uint8_t *data) {
+    // 设置上电策略：最大同时起转数、上电间隔(10ms)、起转窗口(100ms)、SATA1/SATA2/NVMe 优先级
+    power_seq_policy_t new_policy = {
+        .max_active = data[1],
+        .gap_10ms = data[2],
+        .spin_100ms = data[3],
+        .priority = { data[4], data[5], data[6] },
+    };
+    power_seq_set_policy(&new_policy);
+    reply_ok(data);
+}
+
+void cmd_policy_get(uint8_t cmd, const uint8_t *data) {
+    // 返回当前上电策略
+    power_seq_policy_t cur_policy;
+    power_seq_get_policy(&cur_policy);
+    uint8_t policy_payload[3 + POWER_SEQ_SLOT_COUNT] = {
+        cur_policy.max_active,
+        cur_policy.gap_10ms,
+        cur_policy.spin_100ms,
+    };
+    memcpy(policy_payload + 3, cur_policy.priority, POWER_SEQ_SLOT_COUNT);
+    send_hid_response(data[0], policy_payload, sizeof(policy_payload));
+}
+
+void cmd_debounce_set(uint8_t cmd, const uint8_t *data) {
+    // 设置中断引脚防抖窗口(ms)，cmd 为 GPIO 编号
+    irq_set_debounce(cmd, data[1]);
+    reply_ok(data);
+}
+
+void cmd_irq_stats(uint8_t cmd, const uint8_t *data) {
+    // 返回各中断引脚的合并/丢弃事件计数，data[1] 为起始引脚序号，每页最多 5 个引脚
+    // 返回 引脚总数, 起始序号, 本页引脚数, 之后每引脚 GPIO、合并数(u16)、丢弃数(u16)
+    irq_pin_stats_t pin_stats[8];
+    int pin_count = irq_get_pin_stats(pin_stats, 8);
+    uint8_t first = data[1];
+    uint8_t irq_payload[3 + 5 * 5] = {0};
+    uint8_t n = 0;
+    while (n < 5 && first + n < pin_count) {
+        const irq_pin_stats_t *pin = &pin_stats[first + n];
+        uint32_t merged = pin->coalesced + pin->filtered;
+        uint16_t merged16 = merged > 0xFFFF ? 0xFFFF : merged;
+        uint16_t dropped16 = pin->dropped > 0xFFFF ? 0xFFFF : pin->dropped;
+        irq_payload[3 + n * 5] = pin->gpio_num;
+        memcpy(irq_payload + 3 + n * 5 + 1, &merged16, 2);
+        memcpy(irq_payload + 3 + n * 5 + 3, &dropped16, 2);
+        n++;
+    }
+    irq_payload[0] = pin_count;
+    irq_payload[1] = first;
+    irq_payload[2] = n;
+    send_hid_response(data[0], irq_payload, 3 + n * 5);
+}
+
+void cmd_push_subscribe(uint8_t cmd, const uint8_t *data) {
+    // 订阅供电轨变化推送：data[1] 为供电轨掩码(0 取消订阅)，data[2..3] 为最小推送间隔(ms)
+    uint16_t push_interval_ms;
+    memcpy(&push_interval_ms, data + 2, 2);
+    state_push_subscribe(data[1], push_interval_ms);
+    uint8_t rail_levels[3] = {'O', 'K', state_push_rail_levels()};
+    send_hid_response(data[0], rail_levels, sizeof(rail_levels));
+    if (data[1] != 0x00) {
+        start_hid_alive_task();
+    }
+}
+
+void cmd_event_log_read(uint8_t cmd, const uint8_t *data) {
+    // 读取二进制事件日志：data[1..4] 为起始序号，返回实际起始序号(u32)、条数与记录
+    uint32_t log_seq;
+    memcpy(&log_seq, data + 1, 4);
+    event_record_t records[3];
+    int record_count = event_log_read(&log_seq, records, 3);
+    uint8_t log_payload[5 + sizeof(records)];
+    memcpy(log_payload, &log_seq, 4);
+    log_payload[4] = record_count;
+    memcpy(log_payload + 5, records, record_count * sizeof(event_record_t));
+    send_hid_response(data[0], log_payload, 5 + record_count * sizeof(event_record_t));
+}
+
+void cmd_nvs_flush(uint8_t cmd, const uint8_t *data) {
+    // 立即提交所有待写入的配置并保存磨损计数
+    nvs_flush_state(true);
+    reply_ok(data);
+}
+
+void cmd_nvs_wear(uint8_t cmd, const uint8_t *data) {
+    // 查询键的累计提交次数：data[1..15] 为键名(如 "gpio_34")，返回该键次数(u32)与总提交次数(u32)
+    char key[16];
+    memcpy(key, data + 1, 15);
+    key[15] = '\0';
+    uint32_t count = 0, commits = 0;
+    if (nvs_wear_count(key, &count, &commits) != ESP_OK) {
+        send_hid_response(data[0], (const uint8_t *)"INV", 3);
+        return;
+    }
+    uint8_t payload[8];
+    memcpy(payload, &count, 4);
+    memcpy(payload + 4, &commits, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_boot_profile(uint8_t cmd, const uint8_t *data) {
+    // 启动阶段时间：cmd 为 0 读本次启动，1 读上一次启动；data[1] 为起始阶段
+    // 返回 阶段总数, 起始阶段, 本页阶段数, 启动次数(u16), 之后每阶段一个 u32(us, 0 为未到达)
+    uint8_t payload[5 + 6 * 4];
+    uint8_t first = data[1];
+    uint8_t n = 0;
+    uint16_t boots = (uint16_t)boot_prof_boot_count();
+    uint32_t us;
+
+    while (n < 6 && boot_prof_get(cmd != 0, first + n, &us)) {
+        memcpy(payload + 5 + n * 4, &us, 4);
+        n++;
+    }
+    payload[0] = BOOT_PHASE_COUNT;
+    payload[1] = first;
+    payload[2] = n;
+    memcpy(payload + 3, &boots, 2);
+    send_hid_response(data[0], payload, 5 + n * 4);
+}
+
+void cmd_usb_health(uint8_t cmd, const uint8_t *data) {
+    // USB 枚举健康：恢复次数(u16), 卡死/超时/IN 失效次数(各 u16), 总线复位(u16), 挂载(u16),
+    // 最近恢复时间戳(us), 最近损失(ms), 累计损失(ms), 当前退避(ms)
+    usb_health_stats_t stats;
+    uint8_t payload[28];
+    uint16_t counters[6];
+
+    usb_health_get_stats(&stats);
+    counters[0] = stats.recoveries > 0xFFFF ? 0xFFFF : stats.recoveries;
+    for (int i = 0; i < USB_RECOVER_REASON_COUNT; i++) {
+        counters[1 + i] = stats.by_reason[i] > 0xFFFF ? 0xFFFF : stats.by_reason[i];
+    }
+    counters[4] = stats.bus_resets > 0xFFFF ? 0xFFFF : stats.bus_resets;
+    counters[5] = stats.mounts > 0xFFFF ? 0xFFFF : stats.mounts;
+    memcpy(payload, counters, sizeof(counters));
+    memcpy(payload + 12, &stats.last_recovery_us, 4);
+    memcpy(payload + 16, &stats.last_lost_ms, 4);
+    memcpy(payload + 20, &stats.total_lost_ms, 4);
+    memcpy(payload + 24, &stats.backoff_ms, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_latency_hist(uint8_t cmd, const uint8_t *data) {
+    // 命令延迟直方图：cmd 低位 0 为处理延迟，1 为端到端延迟；cmd bit7 置位时读取后清零
+    // 返回 12 个桶计数(u16)与最大值(us)
+    latency_hist_t hist;
+    uint8_t payload[LATENCY_BUCKETS * 2 + 4];
+    latency_kind_t kind = (cmd & 0x7F) ? LATENCY_END_TO_END : LATENCY_PROCESS;
+
+    cmd_worker_get_latency(kind, &hist);
+    if (cmd & 0x80) {
+        cmd_worker_reset_latency();
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        uint16_t n = hist.buckets[i] > 0xFFFF ? 0xFFFF : hist.buckets[i];
+        memcpy(payload + i * 2, &n, 2);
+    }
+    memcpy(payload + LATENCY_BUCKETS * 2, &hist.max_us, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_hid_profile(uint8_t cmd, const uint8_t *data) {
+    // HID 端点配置：cmd 为 0(传统)/1(中断 OUT) 时保存并在复位后生效，0xFF 只查询
+    // 返回 当前配置, 已保存配置, IN 间隔(ms), OUT 间隔(ms, 0 为 EP0)
+    if (cmd != 0xFF) {
+        if (cmd >= HID_PROFILE_COUNT) {
+            send_hid_response(data[0], (const uint8_t *)"INV", 3);
+            return;
+        }
+        hid_profile_store(cmd);
+    }
+    uint8_t payload[4] = {
+        hid_profile_active(),
+        hid_profile_stored(),
+        hid_profile_in_interval(),
+        hid_profile_out_interval(),
+    };
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_hid_tx_stats(uint8_t cmd, const uint8_t *data) {
+    // 发送队列统计：已发送, 重试, 回复/推送/心跳丢弃数, 回复队列最高水位(均为 u32)
+    hid_tx_stats_t stats;
+    uint8_t payload[24];
+
+    hid_tx_get_stats(&stats);
+    memcpy(payload, &stats.sent, 4);
+    memcpy(payload + 4, &stats.retries, 4);
+    memcpy(payload + 8, stats.dropped, 12);
+    memcpy(payload + 20, &stats.reply_high_water, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_proto_window(uint8_t cmd, const uint8_t *data) {
+    // 协议能力与在途窗口：cmd 非 0 时设置窗口(超出范围时取最大值)
+    // 返回 协议版本, 最大窗口, 当前窗口, 当前在途命令数
+    if (cmd != 0) {
+        cmd_worker_set_window(cmd);
+    }
+    uint8_t payload[4] = {
+        0x02,
+        CMD_QUEUE_DEPTH,
+        cmd_worker_get_window(),
+        (uint8_t)cmd_worker_in_flight(),
+    };
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+static void reply_offset(const uint8_t *data, uint32_t offset) {
+    send_hid_response(data[0], (const uint8_t *)&offset, 4);
+}
+
+void cmd_ota_begin(uint8_t cmd, const uint8_t *data) {
+    // HID OTA 开始：data[1..4] 为镜像大小；同样大小的会话未结束时续传，返回起始偏移(u32)
+    uint32_t size, offset;
+    memcpy(&size, data + 1, 4);
+    if (hid_ota_begin(size, &offset) != ESP_OK) {
+        send_hid_response(data[0], (const uint8_t *)"ERR", 3);
+        return;
+    }
+    reply_offset(data, offset);
+}
+
+void cmd_ota_hash(uint8_t cmd, const uint8_t *data) {
+    // 期望的 SHA-256：cmd 为 0/1 表示前/后半，data[1..16] 为 16 字节摘要
+    if (hid_ota_set_hash(cmd, data + 1) != ESP_OK) {
+        send_hid_response(data[0], (const uint8_t *)"ERR", 3);
+        return;
+    }
+    reply_ok(data);
+}
+
+void cmd_ota_data(uint8_t cmd, const uint8_t *data) {
+    // 数据块：cmd 为长度(<= 24)，data[1..4] 为偏移，data[5..] 为数据；返回下一个期望偏移(u32)
+    // 偏移不连续时返回 "OFS" + 期望偏移，主机从该处重发
+    uint32_t offset, next;
+    memcpy(&offset, data + 1, 4);
+    esp_err_t err = cmd > OTA_CHUNK_MAX ? ESP_ERR_INVALID_SIZE : hid_ota_write(offset, data + 5, cmd, &next);
+    if (err == ESP_OK) {
+        reply_offset(data, next);
+    } else if (err == ESP_ERR_INVALID_ARG) {
+        uint8_t payload[7] = { 'O', 'F', 'S' };
+        memcpy(payload + 3, &next, 4);
+        send_hid_response(data[0], payload, sizeof(payload));
+    } else {
+        send_hid_response(data[0], (const uint8_t *)"ERR", 3);
+    }
+}
+
+void cmd_ota_commit(uint8_t cmd, const uint8_t *data) {
+    // 校验并切换启动分区；cmd 为 1 时回复后立即重启
+    esp_err_t err = hid_ota_commit();
+    if (err == ESP_ERR_INVALID_CRC) {
+        send_hid_response(data[0], (const uint8_t *)"HASH", 4);
+        return;
+    }
+    if (err != ESP_OK) {
+        send_hid_response(data[0], (const uint8_t *)"ERR", 3);
+        return;
+    }
+    reply_ok(data);
+    if (cmd == 0x01) {
+        ESP_LOGW(TAG, "Restarting into new firmware...");
+        nvs_flush_state(true);
+        vTaskDelay(pdMS_TO_TICKS(500));
+        esp_restart();
+    }
+}
+
+void cmd_ota_status(uint8_t cmd, const uint8_t *data) {
+    // OTA 状态：cmd 为 1 时先中止当前会话
+    // 返回 状态, 大小, 已接收偏移, 速率(B/s), 耗时(ms), flash 写入次数, 最近错误码
+    ota_status_t status;
+    uint8_t payload[25];
+
+    if (cmd == 0x01) {
+        hid_ota_abort();
+    }
+    hid_ota_get_status(&status);
+    payload[0] = status.state;
+    memcpy(payload + 1, &status.size, 4);
+    memcpy(payload + 5, &status.offset, 4);
+    memcpy(payload + 9, &status.bytes_per_s, 4);
+    memcpy(payload + 13, &status.elapsed_ms, 4);
+    memcpy(payload + 17, &status.flash_writes, 4);
+    memcpy(payload + 21, &status.last_err, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_vendor_stats(uint8_t cmd, const uint8_t *data) {
+    // vendor 批量通道统计：收/发帧数, 收/发字节数, HMAC 失败, 非法帧(均为 u32)；未启用时全为 0
+    vb_stats_t stats;
+    vendor_bulk_get_stats(&stats);
+    send_hid_response(data[0], (const uint8_t *)&stats, sizeof(stats));
+}
+
+void cmd_rail_latency(uint8_t cmd, const uint8_t *data) {
+    // HDDPC 边沿到供电轨写入的延迟：cmd 低 4 位为槽位(0 SATA1, 1 SATA2, 2 NVMe)，bit4 为方向(1 上电)，
+    // bit7 置位时读取后清零全部统计。返回 次数, 最小, 最大, p50, p99(us, 均为 u32), 未执行次数(u32)
+    rail_latency_t lat;
+    uint8_t payload[24];
+
+    if (!power_seq_get_latency(cmd & 0x0F, (cmd >> 4) & 0x01, &lat)) {
+        send_hid_response(data[0], (const uint8_t *)"INV", 3);
+        return;
+    }
+    if (cmd & 0x80) {
+        power_seq_reset_latency();
+    }
+    uint32_t p50 = rail_latency_percentile(&lat, 500);
+    uint32_t p99 = rail_latency_percentile(&lat, 990);
+    memcpy(payload, &lat.count, 4);
+    memcpy(payload + 4, &lat.min_us, 4);
+    memcpy(payload + 8, &lat.max_us, 4);
+    memcpy(payload + 12, &p50, 4);
+    memcpy(payload + 16, &p99, 4);
+    memcpy(payload + 20, &lat.unserved, 4);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+#define SNAPSHOT_VERSION 0x02
+
+// SWITCH_GPIO_MASK 中各引脚在快照位图里的位序
+static const uint8_t snapshot_gpios[] = {
+    GPIO_NUM_14, GPIO_NUM_21, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35,
+    GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_45,
+};
+
+static uint16_t snapshot_live_levels(void) {
+    uint16_t live = 0;
+    for (int i = 0; i < sizeof(snapshot_gpios); i++) {
+        live |= (gpio_get_level(snapshot_gpios[i]) ? 1 : 0) << i;
+    }
+    return live;
+}
+
+void cmd_gpio_batch(uint8_t cmd, const uint8_t *data) {
+    // 批量设置 GPIO：data[1..2] 置高位图，data[3..4] 置低位图，data[5..6] 保存位图，位序同快照。
+    // 非槽位引脚一次端口寄存器写入；硬盘槽位的上电交给上电序列器（sata_onpower 等待与起转策略），
+    // 不会被同时拉高。一次 NVS 提交，返回写入后的实时电平位图与仍在等待上电的位图
+    uint16_t set_bits, clear_bits, persist_bits;
+    memcpy(&set_bits, data + 1, 2);
+    memcpy(&clear_bits, data + 3, 2);
+    memcpy(&persist_bits, data + 5, 2);
+
+    uint16_t valid_bits = (1 << sizeof(snapshot_gpios)) - 1;
+    if ((set_bits | clear_bits | persist_bits) & ~valid_bits || (set_bits & clear_bits)) {
+        send_hid_response(data[0], (const uint8_t *)"INV", 3);
+        return;
+    }
+
+    uint64_t set_mask = 0, clear_mask = 0;
+    uint16_t sequenced_bits = 0;
+    uint8_t persist_pins[sizeof(snapshot_gpios)];
+    uint8_t persist_values[sizeof(snapshot_gpios)];
+    int persist_count = 0;
+    for (int i = 0; i < sizeof(snapshot_gpios); i++) {
+        uint8_t pin = snapshot_gpios[i];
+        if ((set_bits & (1 << i)) && power_seq_is_slot(pin)) {
+            sequenced_bits |= 1 << i;
+        } else if (set_bits & (1 << i)) {
+            set_mask |= 1ULL << pin;
+        } else if (clear_bits & (1 << i)) {
+            clear_mask |= 1ULL << pin;
+            power_seq_note_level(pin, 0);
+        }
+    }
+
+    gpio_write_port(set_mask, clear_mask);
+    state_push_notify();
+
+    uint32_t sata_delay_ms = get_nvs_state(0x00, "sata_onpower") * 1000;
+    for (int i = 0; i < sizeof(snapshot_gpios); i++) {
+        uint8_t pin = snapshot_gpios[i];
+        if (sequenced_bits & (1 << i)) {
+            power_seq_request(pin, 1, (pin == 0x22 || pin == 0x26) ? sata_delay_ms : 0);
+        }
+        if (persist_bits & (1 << i)) {
+            // 等待上电的槽位按目标电平保存
+            persist_pins[persist_count] = pin;
+            persist_values[persist_count] = (set_bits & (1 << i)) ? 1 : (clear_bits & (1 << i)) ? 0 : gpio_get_level(pin);
+            persist_count++;
+        }
+    }
+
+    uint16_t live = snapshot_live_levels();
+    uint8_t payload[4];
+    sequenced_bits &= ~live;
+    memcpy(payload, &live, 2);
+    memcpy(payload + 2, &sequenced_bits, 2);
+    send_hid_response(data[0], payload, sizeof(payload));
+    save_state_batch(persist_pins, persist_values, persist_count, "gpio");
+}
+
+// 解析 "v主.次.修订"，缺失或非数字的字段记为 0
+static void parse_version(const char *text, uint8_t out[3]) {
+    memset(out, 0, 3);
+    if (*text == 'v') {
+        text++;
+    }
+    for (int field = 0; field < 3 && *text != '\0'; field++) {
+        unsigned value = 0;
+        while (*text >= '0' && *text <= '9') {
+            value = value * 10 + (*text++ - '0');
+        }
+        out[field] = value > 0xFF ? 0xFF : value;
+        if (*text != '.') {
+            break;
+        }
+        text++;
+    }
+}
+
+void cmd_snapshot(uint8_t cmd, const uint8_t *data) {
+    // 单帧返回完整设备状态：
+    // [0] 快照版本 [1..2] 实时电平位图 [3..4] gpio_* 位图 [5..6] ext_gpio_* 位图
+    // [7] 硬盘盒模式 [8] sata_onpower [9] susp_en [10] ususp_en [11] ext_restart
+    // [12] 输入电平(bit0 总线供电, bit1..3 HDDPC1..3) [13..15] 固件版本 [16] 位图引脚数
+    // [17..18] gpio_* 已保存位图 [19..20] ext_gpio_* 已保存位图
+    // [21] 全局项已保存位(bit0..4 依次为 [7]..[11])；未保存的项取值为 0
+    const enclosure_config_t *config = get_config();
+    uint16_t live = snapshot_live_levels(), saved = 0, ext_saved = 0, present = 0, ext_present = 0;
+    uint8_t payload[22];
+
+    config_lock();
+    for (int i = 0; i < sizeof(snapshot_gpios); i++) {
+        uint8_t pin = snapshot_gpios[i];
+        saved |= (config->gpio[pin].value ? 1 : 0) << i;
+        ext_saved |= (config->ext_gpio[pin].value ? 1 : 0) << i;
+        present |= (config->gpio[pin].present ? 1 : 0) << i;
+        ext_present |= (config->ext_gpio[pin].present ? 1 : 0) << i;
+    }
+    const config_entry_t *scalars[] = {
+        &config->enclosure_mode, &config->sata_onpower, &config->susp_en, &config->ususp_en, &config->ext_restart,
+    };
+    payload[21] = 0;
+    for (int i = 0; i < sizeof(scalars) / sizeof(scalars[0]); i++) {
+        payload[7 + i] = scalars[i]->value;
+        payload[21] |= (scalars[i]->present ? 1 : 0) << i;
+    }
+    config_unlock();
+
+    payload[0] = SNAPSHOT_VERSION;
+    memcpy(payload + 1, &live, 2);
+    memcpy(payload + 3, &saved, 2);
+    memcpy(payload + 5, &ext_saved, 2);
+    payload[12] = (gpio_get_level(GPIO_NUM_1) ? 0x01 : 0) |
+                  (gpio_get_level(GPIO_NUM_13) ? 0x02 : 0) |
+                  (gpio_get_level(GPIO_NUM_12) ? 0x04 : 0) |
+                  (gpio_get_level(GPIO_NUM_11) ? 0x08 : 0);
+    parse_version(current_version, payload + 13);
+    payload[16] = sizeof(snapshot_gpios);
+    memcpy(payload + 17, &present, 2);
+    memcpy(payload + 19, &ext_present, 2);
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+void cmd_apply_all(uint8_t cmd, const uint8_t *data) {
+    // 应用全GPIO
+    restore_state();
+    ESP_LOGI(TAG, "Applied all GPIO");
+}
+
+void cmd_reset(uint8_t cmd, const uint8_t *data) {
+    // 重置ESP32
+    ESP_LOGI(TAG, "ESP32 Reset");
+    nvs_flush_state(true);
+    esp_restart();
+}
+
+void cmd_dfu(uint8_t cmd, const uint8_t *data) {
+    // dfu_update
+    enter_dfu_mode();
+}
+
+void cmd_version(uint8_t cmd, const uint8_t *data) {
+    // version_return
+    send_hid_response(data[0], (const uint8_t *)current_version, strlen(current_version));
+}
+
+static cmd_stats_t cmd_stats[256];
+
+void cmd_opcode_stats(uint8_t cmd, const uint8_t *data) {
+    // 返回 cmd 所指操作码的调用次数、拒绝次数、累计执行时间(us)及表项属性
+    const cmd_stats_t *stats = &cmd_stats[cmd];
+    const cmd_spec_t *entry = command_lookup(cmd);
+    uint8_t payload[14];
+    memcpy(payload, &stats->calls, 4);
+    memcpy(payload + 4, &stats->rejects, 4);
+    memcpy(payload + 8, &stats->total_us, 4);
+    payload[12] = entry ? entry->payload_len : 0;
+    payload[13] = entry ? entry->flags : 0;
+    send_hid_response(data[0], payload, sizeof(payload));
+}
+
+// data_len 为 data 中经过 HMAC 覆盖的字节数，用于检查操作码的 payload_len
+static void dispatch_command(uint8_t cmd, const uint8_t *data, size_t data_len) {
+    event_log_record(EVT_COMMAND, data[0], cmd, data[1]);
     if (cmd == 0xFE) {
         // 处理 PING 命令
         send_hid_response(cmd, (const uint8_t *)"PONG", 4);
         return;
-    } else {
-        switch (data[0])
-        {
-        case 0x01:
-            if (data[4] == 0x01) {
-                gpio_set_level(cmd, 1);
-            }
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            if (data[1] == 0x01) {
-                save_state(cmd, 1, "gpio");
-                // ESP_LOGI(TAG, "NVS save %d: 1", cmd);
-            }
-            break;
-        case 0x00:
-            if (data[4] == 0x01) {
-                gpio_set_level(cmd, 0);
-            }
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            if (data[1] == 0x01) {
-                save_state(cmd, 0, "gpio");
-                // ESP_LOGI(TAG, "NVS save %d: 0", cmd);
-            }
-            break;
-        case 0x02:
-            // 查询NVS存储的GPIO状态
-            uint8_t value = get_nvs_state(cmd, "gpio");
-            const char *saved_response = value ? "HIGH" : "LOW";
-            send_hid_response(data[0], (const uint8_t *)saved_response, strlen(saved_response));
-            break;
-        case 0x03:
-            // 查询当前的GPIO状态
-            int gpio_level = gpio_get_level(cmd);
-            ESP_LOGI(TAG, "GPIO %d level: %d", cmd, gpio_level);
-            const char *response = gpio_level ? "HIGH" : "LOW";
-            send_hid_response(data[0], (const uint8_t *)response, strlen(response));
-            break;
-        case 0x04:
-            // 查询NVS存储的硬盘盒状态
-            uint8_t enclosure_status = enclosure_mode_selected();
-            send_hid_response(data[0], &enclosure_status, 1);
-            break;
-        case 0x05:
-            // 硬盘盒模式存储
-            save_state(0x00, cmd, "enclosure_mode");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0x06:
-            // 存储高电平时的GPIO状态
-            save_state(cmd, data[3], "ext_gpio");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0x07:
-            // 查询NVS存储的EXT GPIO状态
-            uint8_t ext_value = get_nvs_state(cmd, "ext_gpio");
-            const char *ext_saved_response = ext_value ? "HIGH" : "LOW";
-            send_hid_response(data[0], (const uint8_t *)ext_saved_response, strlen(ext_saved_response));
-            break;
-        case 0x08:
-            // 存储SATA上电时间
-            save_state(0x00, cmd, "sata_onpower");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0x09:
-            // 向主机端返回SATA上电时间
-            uint8_t sata_onpower_time = get_nvs_state(cmd, "sata_onpower");
-            send_hid_response(data[0], &sata_onpower_time, 1);
-            break;
-        case 0x0A:
-            // 是否开启主机端休眠
-            save_state(0x00, cmd, "susp_en");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0x0B:
-            // 向主机端返回主机端休眠状态
-            uint8_t suspend_value = get_nvs_state(cmd, "susp_en");
-            const char *suspend_enable = suspend_value ? "HIGH" : "LOW";
-            send_hid_response(data[0], (const uint8_t *)suspend_enable, strlen(suspend_enable));
-            break;
-        case 0x0C:
-            // 是否开启卸载休眠
-            save_state(0x00, cmd, "ususp_en");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0x0D:
-            // 向主机端返回卸载休眠状态
-            uint8_t umounted_suspend_value = get_nvs_state(0x00, "ususp_en");
-            const char *umounted_suspend_enable = umounted_suspend_value ? "HIGH" : "LOW";
-            send_hid_response(data[0], (const uint8_t *)umounted_suspend_enable, strlen(umounted_suspend_enable));
-            break;
-        case 0x0F:
-            // 集体返回供电GPIO的状态
-            uint8_t payload[4] = {
-                get_nvs_state(0x2D, "gpio"),
-                get_nvs_state(0x22, "gpio"),
-                get_nvs_state(0x26, "gpio"),
-                gpio_get_level(0x01)
-            };
-            send_hid_response(0x00, payload, sizeof(payload));
-            break;
-        case 0x10:
-            // 当外置供电插入时是否重启（保存值）
-            save_state(0x00, cmd, "ext_restart");
-            send_hid_response(data[0], (const uint8_t *)"OK", 2);
-            break;
-        case 0xFD:
-            // 应用全GPIO
-            restore_state();
-            ESP_LOGI(TAG, "Applied all GPIO");
-            break;
-        case 0xFC:
-            // 重置ESP32
-            ESP_LOGI(TAG, "ESP32 Reset");
-            esp_restart();
-            break;
-        case 0xFB:
-            // dfu_update
-            enter_dfu_mode();
-            break;
-        case 0xFA:
-            // version_return
-            send_hid_response(data[0], (const uint8_t *)current_version, strlen(current_version));
-            break;
-        default:
-            // 未知指令
-            send_hid_response(data[0], (const uint8_t *)"UNK", 3);
-            break;
+    }
+
+    uint8_t opcode = data[0];
+    cmd_stats_t *stats = &cmd_stats[opcode];
+    cmd_check_t check = command_validate(opcode, cmd, data_len);
+    if (check == CMD_CHECK_UNKNOWN) {
+        // 未知指令
+        stats->rejects++;
+        send_hid_response(opcode, (const uint8_t *)"UNK", 3);
+        return;
+    }
+    if (check != CMD_CHECK_OK) {
+        stats->rejects++;
+        if (check == CMD_CHECK_BAD_GPIO) {
+            ESP_LOGW(TAG, "Opcode 0x%02X rejected GPIO %d", opcode, cmd);
+        } else {
+            ESP_LOGW(TAG, "Opcode 0x%02X needs %d data byte/s, frame has %d", opcode,
+                     command_lookup(opcode)->payload_len, (int)data_len);
         }
+        send_hid_response(opcode, (const uint8_t *)"INV", 3);
+        return;
     }
+
+    int64_t start = esp_timer_get_time();
+    command_lookup(opcode)->handler(cmd, data);
+    stats->calls++;
+    stats->total_us += (uint32_t)(esp_timer_get_time() - start);
+}
+
+void process_command(uint8_t cmd, const uint8_t *data) {
+    dispatch_command(cmd, data, PROTO_V1_DATA_LEN);
+}
+
+void process_command_tagged(uint8_t tag, uint8_t cmd, const uint8_t *data) {
+    current_tag = tag;
+    dispatch_command(cmd, data, PROTO_V2_DATA_LEN);
+    current_tag = PROTO_NO_TAG;
 }
\ No newline at end of file
@@ -2,8 +2,32 @@
 #define PROCESS_COMMANDER_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cmd_table.h"
+
+// 协议 v2：buffer[0] 为 0xFD，buffer[1] 为标签，buffer[2] 为 cmd，buffer[3] 起为 data
+// 回复为 0xFD, 标签, 操作码, 最多 29 字节负载。两个方向的 v2 帧都用 hid_auth_sign_v2()
+// 签名，以 MAC 而不是首字节区分格式，cmd 为 0xFD 的 v1 帧仍按 v1 处理
+#define PROTO_V2_MARKER    0xFD
+#define PROTO_V2_HEADER    3
+#define PROTO_NO_TAG       (-1)
+
+#define PROTO_V1_MAX_PAYLOAD 31
+#define PROTO_V2_MAX_PAYLOAD 29
+// 请求中经过 HMAC 覆盖(字节 0..31)的 data 长度
+#define PROTO_V1_DATA_LEN    (32 - 1)
+#define PROTO_V2_DATA_LEN    (32 - PROTO_V2_HEADER)
+
+typedef struct {
+    uint32_t calls;
+    uint32_t rejects;
+    uint32_t total_us;
+} cmd_stats_t;
 
 void process_command(uint8_t cmd, const uint8_t *data);
+void process_command_tagged(uint8_t tag, uint8_t cmd, const uint8_t *data);
 void send_hid_response(uint8_t command, const uint8_t *payload, size_t payload_len);
+void send_hid_reply_tagged(int tag, uint8_t command, const uint8_t *payload, size_t payload_len);
 
 #endif
\ No newline at end of file
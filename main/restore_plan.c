@@ -0,0 +1,32 @@
+#include <string.h>
+#include "restore_plan.h"
+
+// 恢复顺序与旧版 restore_state() 逐引脚调用的顺序一致
+const uint8_t restore_gpios[RESTORE_GPIO_COUNT] = {
+    GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_38, GPIO_NUM_45, GPIO_NUM_36, GPIO_NUM_37,
+};
+
+// 与 restore_gpio_state()/ext_restore_gpio_state() 的逐引脚语义一致：
+// 未保存的引脚置低并记入 missing_mask，槽位上电交给时序器，SATA 槽位等待 sata_onpower 秒
+void restore_plan_build(restore_plan_t *plan, const enclosure_config_t *config, bool ext_power) {
+    uint32_t sata_delay_ms = config->sata_onpower.value * 1000;
+
+    memset(plan, 0, sizeof(*plan));
+    for (int i = 0; i < RESTORE_GPIO_COUNT; i++) {
+        uint8_t pin = restore_gpios[i];
+        const config_entry_t *entry = (ext_power && i < EXT_RESTORE_GPIO_COUNT) ? &config->ext_gpio[pin] : &config->gpio[pin];
+        uint8_t value = entry->present ? entry->value : 0;
+        if (!entry->present) {
+            plan->missing_mask |= 1ULL << pin;
+        }
+        if (value == 0) {
+            plan->clear_mask |= 1ULL << pin;
+        } else if (POWER_SEQ_SLOT_MASK & (1ULL << pin)) {
+            plan->steps[plan->step_count].gpio_num = pin;
+            plan->steps[plan->step_count].delay_ms = (value == 1 && (pin == 0x22 || pin == 0x26)) ? sata_delay_ms : 0;
+            plan->step_count++;
+        } else {
+            plan->set_mask |= 1ULL << pin;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef RESTORE_PLAN_H
+#define RESTORE_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nvs_handle.h"
+#include "power_seq.h"
+
+#define RESTORE_GPIO_COUNT     7
+#define EXT_RESTORE_GPIO_COUNT 5   // restore_gpios 前 5 个在外部供电时使用 ext_gpio_*
+
+// 恢复计划：按当前配置预先计算的端口置位/清零掩码，以及交给上电时序器的槽位上电步骤
+typedef struct {
+    uint64_t set_mask;
+    uint64_t clear_mask;
+    uint64_t missing_mask;
+    uint8_t step_count;
+    struct {
+        uint8_t gpio_num;
+        uint32_t delay_ms;
+    } steps[POWER_SEQ_SLOT_COUNT];
+} restore_plan_t;
+
+extern const uint8_t restore_gpios[RESTORE_GPIO_COUNT];
+
+void restore_plan_build(restore_plan_t *plan, const enclosure_config_t *config, bool ext_power);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "state_push.h"
+#include "hid_auth.h"
+#include "alive_hid.h"
+
+static const char *TAG = "State Push";
+
+// 供电轨在推送报文中的位序：bit0..bit6
+static const gpio_num_t rail_gpios[] = {
+    GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_45,
+};
+
+static portMUX_TYPE push_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t subscribe_mask = 0;
+static uint32_t min_interval_us = 0;
+static uint8_t last_reported = 0;
+static uint8_t pending_changed = 0;
+static uint8_t last_seen = 0;   // 最近一次 notify 看到的电平，与订阅无关，用于重置心跳退避
+static int64_t last_push_us = 0;
+static uint16_t push_seq = 0;
+
+uint8_t state_push_rail_levels(void) {
+    uint8_t levels = 0;
+    for (int i = 0; i < sizeof(rail_gpios) / sizeof(rail_gpios[0]); i++) {
+        if (gpio_get_level(rail_gpios[i])) {
+            levels |= 1 << i;
+        }
+    }
+    return levels;
+}
+
+void state_push_subscribe(uint8_t change_mask, uint16_t min_interval_ms) {
+    uint8_t levels = state_push_rail_levels();
+    portENTER_CRITICAL(&push_lock);
+    subscribe_mask = change_mask;
+    min_interval_us = (uint32_t)min_interval_ms * 1000;
+    last_reported = levels;
+    pending_changed = 0;
+    portEXIT_CRITICAL(&push_lock);
+    ESP_LOGI(TAG, "Subscribed rail mask 0x%02X, min interval %d ms", change_mask, min_interval_ms);
+}
+
+bool state_push_subscribed(void) {
+    return subscribe_mask != 0;
+}
+
+// 供电轨可能发生变化后调用：任何电平变化都唤醒心跳任务（重置自适应间隔），
+// 有订阅的变化时另外记入待推送位
+void state_push_notify(void) {
+    uint8_t levels = state_push_rail_levels();
+    bool wake = false;
+
+    portENTER_CRITICAL(&push_lock);
+    if (levels != last_seen) {
+        last_seen = levels;
+        wake = true;
+    }
+    uint8_t changed = (levels ^ last_reported) & subscribe_mask;
+    if (changed) {
+        pending_changed |= changed;
+        wake = true;
+    }
+    portEXIT_CRITICAL(&push_lock);
+
+    if (wake) {
+        hid_alive_wake();
+    }
+}
+
+// 距离允许下一次推送还需等待的时间，无待推送变化时返回 UINT32_MAX
+uint32_t state_push_wait_ms(void) {
+    uint32_t wait_ms = UINT32_MAX;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&push_lock);
+    if (pending_changed) {
+        int64_t due = last_push_us + min_interval_us;
+        wait_ms = due > now ? (uint32_t)((due - now + 999) / 1000) : 0;
+    }
+    portEXIT_CRITICAL(&push_lock);
+    return wait_ms;
+}
+
+// 生成一帧带 HMAC 的推送报文：0xFF, 类型, 版本, 当前电平, 变化位, 序号(u16)，与心跳帧同样在类型后带版本
+bool state_push_build(uint8_t *report) {
+    if (state_push_wait_ms() != 0) {
+        return false;
+    }
+    uint8_t levels = state_push_rail_levels();
+
+    portENTER_CRITICAL(&push_lock);
+    uint8_t changed = pending_changed | ((levels ^ last_reported) & subscribe_mask);
+    pending_changed = 0;
+    last_reported = levels;
+    last_push_us = esp_timer_get_time();
+    uint16_t seq = push_seq++;
+    portEXIT_CRITICAL(&push_lock);
+
+    memset(report, 0, 64);
+    report[0] = 0xFF;
+    report[1] = STATE_PUSH_TYPE;
+    report[2] = STATE_PUSH_VERSION;
+    report[3] = levels;
+    report[4] = changed;
+    memcpy(report + 5, &seq, 2);
+    hid_auth_sign(report, 32, report + 32);
+    return true;
+}
\ No newline at end of file
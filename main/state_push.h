@@ -0,0 +1,17 @@
+#ifndef STATE_PUSH_H
+#define STATE_PUSH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STATE_PUSH_TYPE    0x01
+#define STATE_PUSH_VERSION 0x01
+
+void state_push_subscribe(uint8_t change_mask, uint16_t min_interval_ms);
+bool state_push_subscribed(void);
+uint8_t state_push_rail_levels(void);
+void state_push_notify(void);
+uint32_t state_push_wait_ms(void);
+bool state_push_build(uint8_t *report);
+
+#endif
\ No newline at end of file
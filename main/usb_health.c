@@ -0,0 +1,198 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "tusb.h"
+#include "class/hid/hid_device.h"
+#include "usb_health.h"
+#include "alive_hid.h"
+#include "boot_prof.h"
+#include "event_log.h"
+#include "hid_tx.h"
+
+static const char *TAG = "USB Health";
+
+#define USB_VBUS_GPIO          GPIO_NUM_9
+#define USB_CHECK_MS           500
+#define USB_DISCONNECT_HOLD_MS 300     // 断开 D+ 后让主机察觉拔出的最短时间
+#define USB_REENUM_HOLD_MS     1300    // 恢复时的断开时间
+#define USB_STUCK_MS           3000
+#define USB_MOUNT_TIMEOUT_MS   8000
+#define USB_IN_STALL_MS        3000
+#define USB_BACKOFF_MIN_MS     2000
+#define USB_BACKOFF_MAX_MS     60000
+#define USB_HEALTHY_RESET_MS   30000   // 连续正常这么久后退避回到最小值
+
+static TaskHandle_t monitor_handle = NULL;
+static TickType_t boot_disconnect_tick = 0;
+static volatile TickType_t last_host_rx = 0;
+static usb_health_stats_t stats = { .backoff_ms = USB_BACKOFF_MIN_MS };
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void wake_monitor(void) {
+    TaskHandle_t handle = monitor_handle;
+    if (handle != NULL) {
+        xTaskNotifyGive(handle);
+    }
+}
+
+static uint32_t ticks_to_ms(TickType_t ticks) {
+    return (uint32_t)ticks * portTICK_PERIOD_MS;
+}
+
+static void recover(usb_recover_reason_t reason, TickType_t fault_tick) {
+    static const char *const reason_names[] = { "stuck enumeration", "mount timeout", "IN endpoint stall" };
+
+    ESP_LOGW(TAG, "USB %s for %lu ms, forcing re-enumeration (backoff %lu ms)", reason_names[reason],
+             (unsigned long)ticks_to_ms(xTaskGetTickCount() - fault_tick), (unsigned long)stats.backoff_ms);
+    event_log_record(EVT_USB_RECOVERY, 0, reason, (uint8_t)(stats.recoveries & 0xFF));
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.recoveries++;
+    stats.by_reason[reason]++;
+    stats.last_recovery_us = (uint32_t)esp_timer_get_time();
+    portEXIT_CRITICAL(&stats_lock);
+
+    stop_hid_alive_task();
+    tud_disconnect();
+    // Let host detect disconnect and settle before reconnect
+    vTaskDelay(pdMS_TO_TICKS(USB_REENUM_HOLD_MS));
+    tud_connect();
+    start_hid_alive_task();
+}
+
+// 整个固件生命周期内运行：任何时候出现枚举卡死或 IN 端点失效都按指数退避重新枚举
+static void usb_health_task(void *param) {
+    TickType_t elapsed = xTaskGetTickCount() - boot_disconnect_tick;
+    if (elapsed < pdMS_TO_TICKS(USB_DISCONNECT_HOLD_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(USB_DISCONNECT_HOLD_MS) - elapsed);
+    }
+    tud_connect();
+    boot_prof_mark(BOOT_PHASE_USB_CONNECT);
+    ESP_LOGI(TAG, "Waiting for USB to mount...");
+
+    TickType_t unmounted_since = xTaskGetTickCount();
+    TickType_t in_busy_since = 0;
+    TickType_t fault_tick = 0;          // 非 0 表示正在从故障中恢复，挂载后计算损失时间
+    TickType_t next_recovery = 0;
+    TickType_t healthy_since = 0;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(USB_CHECK_MS));
+        TickType_t now = xTaskGetTickCount();
+
+        if (!gpio_get_level(USB_VBUS_GPIO)) {
+            // 主机未供电，没有可恢复的对象
+            unmounted_since = now;
+            in_busy_since = 0;
+            fault_tick = 0;
+            continue;
+        }
+
+        if (!tud_mounted()) {
+            healthy_since = 0;
+            in_busy_since = 0;
+            if (unmounted_since == 0) {
+                unmounted_since = now;
+            }
+            uint32_t waited_ms = ticks_to_ms(now - unmounted_since);
+            usb_recover_reason_t reason;
+            if (tud_connected() && waited_ms > USB_STUCK_MS) {
+                // ESP32-S2 known issue: device electrically connected but not enumerated.
+                reason = USB_RECOVER_STUCK;
+            } else if (waited_ms > USB_MOUNT_TIMEOUT_MS) {
+                reason = USB_RECOVER_TIMEOUT;
+            } else {
+                continue;
+            }
+            if ((int32_t)(now - next_recovery) < 0) {
+                continue;
+            }
+            if (fault_tick == 0) {
+                fault_tick = unmounted_since;
+            }
+            recover(reason, unmounted_since);
+        } else {
+            unmounted_since = 0;
+            // 兜底：完成回调丢失时也能把队列中的帧发出去
+            hid_tx_pump();
+            if (fault_tick != 0) {
+                uint32_t lost_ms = ticks_to_ms(now - fault_tick);
+                fault_tick = 0;
+                portENTER_CRITICAL(&stats_lock);
+                stats.last_lost_ms = lost_ms;
+                stats.total_lost_ms += lost_ms;
+                portEXIT_CRITICAL(&stats_lock);
+                ESP_LOGI(TAG, "USB recovered after %lu ms", (unsigned long)lost_ms);
+            }
+            if (tud_suspended() || tud_hid_ready()) {
+                in_busy_since = 0;
+                if (healthy_since == 0) {
+                    healthy_since = now;
+                } else if (stats.backoff_ms != USB_BACKOFF_MIN_MS &&
+                           ticks_to_ms(now - healthy_since) > USB_HEALTHY_RESET_MS) {
+                    stats.backoff_ms = USB_BACKOFF_MIN_MS;
+                }
+                continue;
+            }
+            // 已挂载且未挂起，但上一份报告一直没被主机取走。主机没打开设备时本来就不会轮询 IN，
+            // 所以只有在此期间主机仍在发送命令时才认为端点失效
+            if (in_busy_since == 0) {
+                in_busy_since = now;
+            }
+            if ((int32_t)(last_host_rx - in_busy_since) <= 0 || ticks_to_ms(now - in_busy_since) <= USB_IN_STALL_MS ||
+                (int32_t)(now - next_recovery) < 0) {
+                continue;
+            }
+            fault_tick = in_busy_since;
+            recover(USB_RECOVER_IN_STALL, in_busy_since);
+            in_busy_since = 0;
+        }
+
+        healthy_since = 0;
+        unmounted_since = xTaskGetTickCount();
+        next_recovery = unmounted_since + pdMS_TO_TICKS(stats.backoff_ms);
+        stats.backoff_ms = stats.backoff_ms * 2 > USB_BACKOFF_MAX_MS ? USB_BACKOFF_MAX_MS : stats.backoff_ms * 2;
+    }
+}
+
+// disconnect_tick：app_main 调用 tud_disconnect() 的时刻，首次连接前补足断开保持时间
+void usb_health_start(TickType_t disconnect_tick) {
+    boot_disconnect_tick = disconnect_tick;
+    xTaskCreate(usb_health_task, "usb_health_task", 3072, NULL, 6, &monitor_handle);
+}
+
+void usb_health_on_mount(void) {
+    portENTER_CRITICAL(&stats_lock);
+    stats.mounts++;
+    portEXIT_CRITICAL(&stats_lock);
+    wake_monitor();
+}
+
+// 收到主机 OUT 报告时调用（TinyUSB 任务上下文）
+void usb_health_on_host_rx(void) {
+    last_host_rx = xTaskGetTickCount();
+}
+
+void usb_health_on_unmount(void) {
+    wake_monitor();
+}
+
+void usb_health_on_reset(void) {
+    portENTER_CRITICAL(&stats_lock);
+    stats.bus_resets++;
+    portEXIT_CRITICAL(&stats_lock);
+    wake_monitor();
+}
+
+void usb_health_on_resume(void) {
+    wake_monitor();
+}
+
+void usb_health_get_stats(usb_health_stats_t *out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
\ No newline at end of file
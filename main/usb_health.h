@@ -0,0 +1,33 @@
+#ifndef USB_HEALTH_H
+#define USB_HEALTH_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    USB_RECOVER_STUCK = 0,   // 已收到总线复位但迟迟未完成枚举
+    USB_RECOVER_TIMEOUT,     // 有 VBUS 但一直未挂载
+    USB_RECOVER_IN_STALL,    // 已挂载但 IN 端点长时间忙
+    USB_RECOVER_REASON_COUNT
+} usb_recover_reason_t;
+
+typedef struct {
+    uint32_t recoveries;
+    uint32_t by_reason[USB_RECOVER_REASON_COUNT];
+    uint32_t bus_resets;
+    uint32_t mounts;
+    uint32_t last_recovery_us;   // 最近一次恢复的时间戳(esp_timer)
+    uint32_t last_lost_ms;       // 最近一次故障到重新挂载的时间
+    uint32_t total_lost_ms;
+    uint32_t backoff_ms;         // 下一次恢复前的最短间隔
+} usb_health_stats_t;
+
+void usb_health_start(TickType_t disconnect_tick);
+void usb_health_on_mount(void);
+void usb_health_on_unmount(void);
+void usb_health_on_reset(void);
+void usb_health_on_resume(void);
+void usb_health_on_host_rx(void);
+void usb_health_get_stats(usb_health_stats_t *out);
+
+#endif
\ No newline at end of file
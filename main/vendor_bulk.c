@@ -0,0 +1,252 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "tusb.h"
+#include "vendor_bulk.h"
+
+#if CFG_TUD_VENDOR
+
+#include "hid_auth.h"
+#include "hid_ota.h"
+#include "event_log.h"
+#include "cmd_worker.h"
+#include "usb_health.h"
+#include "hid_tx.h"
+#include "irq_queue.h"
+#include "power_seq.h"
+#include "boot_prof.h"
+
+static const char *TAG = "Vendor Bulk";
+
+#define VB_FRAME_MAX (VB_HEADER_LEN + VB_MAX_PAYLOAD + HID_AUTH_MAC_LEN)
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint16_t seq;
+    uint16_t len;
+} vb_header_t;
+
+_Static_assert(sizeof(vb_header_t) == VB_HEADER_LEN, "vendor bulk header size");
+// 回复负载从 tx_frame + VB_HEADER_LEN 开始，事件记录数组再偏移 4 字节，均需保持 4 字节对齐
+_Static_assert(VB_HEADER_LEN % 4 == 0 && _Alignof(event_record_t) <= 4, "vendor bulk payload alignment");
+
+static TaskHandle_t vb_handle = NULL;
+static uint8_t rx_frame[VB_FRAME_MAX];
+static uint32_t rx_len = 0;
+static uint8_t tx_frame[VB_FRAME_MAX] __attribute__((aligned(4)));
+static vb_stats_t vb_stats;
+static bool seq_valid = false;
+static uint16_t last_seq = 0;
+
+static void vb_wait(void) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+}
+
+// 把整帧写入 vendor FIFO，FIFO 满时等待 tud_vendor_tx_cb 唤醒
+static void vb_write_all(const uint8_t *buf, uint32_t len) {
+    while (len > 0 && tud_vendor_mounted()) {
+        uint32_t n = tud_vendor_write(buf, len);
+        tud_vendor_write_flush();
+        buf += n;
+        len -= n;
+        if (len > 0) {
+            vb_wait();
+        }
+    }
+}
+
+static void vb_send(uint8_t type, uint16_t seq, uint32_t payload_len) {
+    vb_header_t header = {
+        .magic = VB_MAGIC,
+        .version = VB_VERSION,
+        .type = type | VB_RESPONSE,
+        .seq = seq,
+        .len = (uint16_t)payload_len,
+    };
+    memcpy(tx_frame, &header, VB_HEADER_LEN);
+    hid_auth_sign(tx_frame, VB_HEADER_LEN + payload_len, tx_frame + VB_HEADER_LEN + payload_len);
+    uint32_t total = VB_HEADER_LEN + payload_len + HID_AUTH_MAC_LEN;
+    vb_write_all(tx_frame, total);
+    vb_stats.tx_frames++;
+    vb_stats.tx_bytes += total;
+}
+
+static uint32_t put_tlv(uint8_t *out, uint32_t pos, uint8_t id, const void *value, uint32_t len) {
+    if (pos + 2 + len > VB_MAX_PAYLOAD || len > 0xFF) {
+        return pos;
+    }
+    out[pos] = id;
+    out[pos + 1] = (uint8_t)len;
+    memcpy(out + pos + 2, value, len);
+    return pos + 2 + len;
+}
+
+static uint32_t build_telemetry(uint8_t *out) {
+    cmd_worker_stats_t worker;
+    latency_hist_t hist;
+    usb_health_stats_t health;
+    hid_tx_stats_t tx;
+    irq_pin_stats_t pins[8];
+    power_slot_status_t slots[POWER_SEQ_SLOT_COUNT];
+    uint32_t phases[BOOT_PHASE_COUNT];
+    uint32_t pos = 0;
+
+    cmd_worker_get_stats(&worker);
+    pos = put_tlv(out, pos, 0x01, &worker, sizeof(worker));
+    cmd_worker_get_latency(LATENCY_PROCESS, &hist);
+    pos = put_tlv(out, pos, 0x02, &hist, sizeof(hist));
+    cmd_worker_get_latency(LATENCY_END_TO_END, &hist);
+    pos = put_tlv(out, pos, 0x03, &hist, sizeof(hist));
+    usb_health_get_stats(&health);
+    pos = put_tlv(out, pos, 0x04, &health, sizeof(health));
+    hid_tx_get_stats(&tx);
+    pos = put_tlv(out, pos, 0x05, &tx, sizeof(tx));
+    int pin_count = irq_get_pin_stats(pins, 8);
+    pos = put_tlv(out, pos, 0x06, pins, pin_count * sizeof(pins[0]));
+    power_seq_get_status(slots);
+    pos = put_tlv(out, pos, 0x07, slots, sizeof(slots));
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        boot_prof_get(false, i, &phases[i]);
+    }
+    pos = put_tlv(out, pos, 0x08, phases, sizeof(phases));
+    pos = put_tlv(out, pos, 0x09, &vb_stats, sizeof(vb_stats));
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT * 2; i++) {
+        // 0x10 + 槽位 * 2 + 方向：完整的供电轨延迟直方图
+        rail_latency_t lat;
+        power_seq_get_latency(i / 2, i % 2, &lat);
+        pos = put_tlv(out, pos, 0x10 + i, &lat, sizeof(lat));
+    }
+    return pos;
+}
+
+static void vb_handle_frame(const vb_header_t *header, const uint8_t *payload) {
+    uint8_t *out = tx_frame + VB_HEADER_LEN;
+
+    switch (header->type) {
+    case VB_EVENT_LOG: {
+        // 一帧最多装满 VB_MAX_PAYLOAD，主机用返回的 next_seq 继续读取
+        uint32_t seq = 0;
+        if (header->len >= 4) {
+            memcpy(&seq, payload, 4);
+        }
+        int max = (VB_MAX_PAYLOAD - 4) / sizeof(event_record_t);
+        int count = event_log_read(&seq, (event_record_t *)(out + 4), max);
+        // event_log_read 把 seq 调整为实际起始序号（旧记录已被覆盖时会前移），下一页从其后开始
+        uint32_t next_seq = seq + count;
+        memcpy(out, &next_seq, 4);
+        vb_send(header->type, header->seq, 4 + count * sizeof(event_record_t));
+        break;
+    }
+    case VB_OTA_DATA: {
+        uint32_t offset = 0, next = 0;
+        esp_err_t err = ESP_ERR_INVALID_SIZE;
+        if (header->len > 4) {
+            memcpy(&offset, payload, 4);
+            err = hid_ota_write(offset, payload + 4, header->len - 4, &next);
+        }
+        out[0] = err == ESP_OK ? 0x00 : (err == ESP_ERR_INVALID_ARG ? 0x01 : 0xFF);
+        memcpy(out + 1, &next, 4);
+        vb_send(header->type, header->seq, 5);
+        break;
+    }
+    case VB_TELEMETRY:
+        vb_send(header->type, header->seq, build_telemetry(out));
+        break;
+    default:
+        vb_stats.bad_frames++;
+        vb_send(header->type, header->seq, 0);
+        break;
+    }
+}
+
+// 只接受序号前进的帧(按 16 位回绕比较)，已签名的旧帧不能被重放；启动后的第一帧确定起点
+static bool vb_seq_advances(uint16_t seq) {
+    if (seq_valid && (int16_t)(seq - last_seq) <= 0) {
+        return false;
+    }
+    seq_valid = true;
+    last_seq = seq;
+    return true;
+}
+
+// 从接收缓冲中解析完整帧；头部非法时丢弃 1 字节重新同步
+static void vb_parse(void) {
+    while (rx_len >= VB_HEADER_LEN) {
+        vb_header_t header;
+        memcpy(&header, rx_frame, VB_HEADER_LEN);
+        if (header.magic != VB_MAGIC || header.version != VB_VERSION || header.len > VB_MAX_PAYLOAD) {
+            vb_stats.bad_frames++;
+            memmove(rx_frame, rx_frame + 1, --rx_len);
+            continue;
+        }
+        uint32_t total = VB_HEADER_LEN + header.len + HID_AUTH_MAC_LEN;
+        if (rx_len < total) {
+            return;
+        }
+        vb_stats.rx_frames++;
+        if (!hid_auth_verify(rx_frame, VB_HEADER_LEN + header.len, rx_frame + VB_HEADER_LEN + header.len)) {
+            vb_stats.auth_fail++;
+            ESP_LOGW(TAG, "HMAC mismatch on frame %u", header.seq);
+        } else if (!vb_seq_advances(header.seq)) {
+            // 回复最后接受的序号，主机据此重新同步
+            vb_stats.replayed++;
+            ESP_LOGW(TAG, "Frame %u does not advance past %u, dropped", header.seq, last_seq);
+            memcpy(tx_frame + VB_HEADER_LEN, &last_seq, 2);
+            vb_send(VB_SEQ_REJECT, header.seq, 2);
+        } else {
+            vb_handle_frame(&header, rx_frame + VB_HEADER_LEN);
+        }
+        rx_len -= total;
+        memmove(rx_frame, rx_frame + total, rx_len);
+    }
+}
+
+static void vendor_bulk_task(void *param) {
+    while (1) {
+        vb_wait();
+        if (!tud_vendor_mounted()) {
+            rx_len = 0;
+            continue;
+        }
+        while (tud_vendor_available() > 0 && rx_len < sizeof(rx_frame)) {
+            uint32_t n = tud_vendor_read(rx_frame + rx_len, sizeof(rx_frame) - rx_len);
+            rx_len += n;
+            vb_stats.rx_bytes += n;
+            vb_parse();
+        }
+    }
+}
+
+void tud_vendor_rx_cb(uint8_t itf, uint8_t const *buffer, uint16_t bufsize) {
+    if (vb_handle != NULL) {
+        xTaskNotifyGive(vb_handle);
+    }
+}
+
+void tud_vendor_tx_cb(uint8_t itf, uint32_t sent_bytes) {
+    if (vb_handle != NULL) {
+        xTaskNotifyGive(vb_handle);
+    }
+}
+
+void vendor_bulk_start(void) {
+    xTaskCreate(vendor_bulk_task, "vendor_bulk", 4096, NULL, 3, &vb_handle);
+}
+
+void vendor_bulk_get_stats(vb_stats_t *out) {
+    *out = vb_stats;
+}
+
+#else
+
+void vendor_bulk_start(void) {
+}
+
+void vendor_bulk_get_stats(vb_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef VENDOR_BULK_H
+#define VENDOR_BULK_H
+
+#include <stdint.h>
+
+// 批量通道帧：头部 + 负载 + HMAC-SHA256(头部 + 负载)
+#define VB_MAGIC        0x4252   // "RB"
+#define VB_VERSION      0x01
+#define VB_HEADER_LEN   8
+#define VB_MAX_PAYLOAD  4096
+#define VB_RESPONSE     0x80     // 回复帧类型 = 请求类型 | 0x80
+
+typedef enum {
+    VB_EVENT_LOG = 0x01,   // 请求: from_seq(u32)；回复: next_seq(u32) + event_record_t 数组
+    VB_OTA_DATA  = 0x02,   // 请求: offset(u32) + 数据；回复: 状态(u8) + next_offset(u32)
+    VB_TELEMETRY = 0x03,   // 请求: 无；回复: TLV(id u8, len u8, 原始结构体)
+    VB_SEQ_REJECT = 0x7F,  // 只出现在回复中：请求 seq 未超过上一帧，负载为最后接受的 seq(u16)
+} vb_type_t;
+
+typedef struct {
+    uint32_t rx_frames;
+    uint32_t tx_frames;
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t auth_fail;
+    uint32_t bad_frames;
+    uint32_t replayed;     // 通过校验但 seq 未前进而被丢弃的帧
+} vb_stats_t;
+
+void vendor_bulk_start(void);
+void vendor_bulk_get_stats(vb_stats_t *out);
+
+#endif
\ No newline at end of file
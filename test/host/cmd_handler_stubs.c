@@ -0,0 +1,98 @@
+#include "cmd_table.h"
+
+// 主机测试中代替 process_commander.c 的处理函数桩
+void cmd_gpio_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_gpio_saved(uint8_t cmd, const uint8_t *data) { }
+void cmd_gpio_live(uint8_t cmd, const uint8_t *data) { }
+void cmd_enclosure_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_enclosure_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_ext_gpio_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_ext_gpio_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_onpower_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_onpower_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_susp_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_susp_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_ususp_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_ususp_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_power_summary(uint8_t cmd, const uint8_t *data) { }
+void cmd_ext_restart_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_worker_stats(uint8_t cmd, const uint8_t *data) { }
+void cmd_power_seq_status(uint8_t cmd, const uint8_t *data) { }
+void cmd_policy_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_policy_get(uint8_t cmd, const uint8_t *data) { }
+void cmd_debounce_set(uint8_t cmd, const uint8_t *data) { }
+void cmd_irq_stats(uint8_t cmd, const uint8_t *data) { }
+void cmd_push_subscribe(uint8_t cmd, const uint8_t *data) { }
+void cmd_event_log_read(uint8_t cmd, const uint8_t *data) { }
+void cmd_opcode_stats(uint8_t cmd, const uint8_t *data) { }
+void cmd_snapshot(uint8_t cmd, const uint8_t *data) { }
+void cmd_gpio_batch(uint8_t cmd, const uint8_t *data) { }
+void cmd_nvs_flush(uint8_t cmd, const uint8_t *data) { }
+void cmd_nvs_wear(uint8_t cmd, const uint8_t *data) { }
+void cmd_boot_profile(uint8_t cmd, const uint8_t *data) { }
+void cmd_usb_health(uint8_t cmd, const uint8_t *data) { }
+void cmd_latency_hist(uint8_t cmd, const uint8_t *data) { }
+void cmd_hid_profile(uint8_t cmd, const uint8_t *data) { }
+void cmd_hid_tx_stats(uint8_t cmd, const uint8_t *data) { }
+void cmd_proto_window(uint8_t cmd, const uint8_t *data) { }
+void cmd_ota_begin(uint8_t cmd, const uint8_t *data) { }
+void cmd_ota_hash(uint8_t cmd, const uint8_t *data) { }
+void cmd_ota_data(uint8_t cmd, const uint8_t *data) { }
+void cmd_ota_commit(uint8_t cmd, const uint8_t *data) { }
+void cmd_ota_status(uint8_t cmd, const uint8_t *data) { }
+void cmd_vendor_stats(uint8_t cmd, const uint8_t *data) { }
+void cmd_rail_latency(uint8_t cmd, const uint8_t *data) { }
+void cmd_version(uint8_t cmd, const uint8_t *data) { }
+void cmd_dfu(uint8_t cmd, const uint8_t *data) { }
+void cmd_reset(uint8_t cmd, const uint8_t *data) { }
+void cmd_apply_all(uint8_t cmd, const uint8_t *data) { }
+
+// 与 cmd_table.h 中声明的处理函数一一对应
+const cmd_handler_t all_handlers[] = {
+    cmd_gpio_set,
+    cmd_gpio_saved,
+    cmd_gpio_live,
+    cmd_enclosure_get,
+    cmd_enclosure_set,
+    cmd_ext_gpio_set,
+    cmd_ext_gpio_get,
+    cmd_onpower_set,
+    cmd_onpower_get,
+    cmd_susp_set,
+    cmd_susp_get,
+    cmd_ususp_set,
+    cmd_ususp_get,
+    cmd_power_summary,
+    cmd_ext_restart_set,
+    cmd_worker_stats,
+    cmd_power_seq_status,
+    cmd_policy_set,
+    cmd_policy_get,
+    cmd_debounce_set,
+    cmd_irq_stats,
+    cmd_push_subscribe,
+    cmd_event_log_read,
+    cmd_opcode_stats,
+    cmd_snapshot,
+    cmd_gpio_batch,
+    cmd_nvs_flush,
+    cmd_nvs_wear,
+    cmd_boot_profile,
+    cmd_usb_health,
+    cmd_latency_hist,
+    cmd_hid_profile,
+    cmd_hid_tx_stats,
+    cmd_proto_window,
+    cmd_ota_begin,
+    cmd_ota_hash,
+    cmd_ota_data,
+    cmd_ota_commit,
+    cmd_ota_status,
+    cmd_vendor_stats,
+    cmd_rail_latency,
+    cmd_version,
+    cmd_dfu,
+    cmd_reset,
+    cmd_apply_all,
+};
+const int all_handler_count = sizeof(all_handlers) / sizeof(all_handlers[0]);
\ No newline at end of file
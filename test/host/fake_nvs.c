@@ -0,0 +1,149 @@
+#include <string.h>
+#include "fake_nvs.h"
+#include "nvs_flash.h"
+
+#define FAKE_NVS_MAX_KEYS 128
+#define FAKE_NVS_MAX_BLOB 512
+
+typedef struct {
+    char key[16];
+    size_t length;
+    uint8_t data[FAKE_NVS_MAX_BLOB];
+} fake_entry_t;
+
+static fake_entry_t entries[FAKE_NVS_MAX_KEYS];
+static int entry_count = 0;
+fake_nvs_stats_t fake_nvs_stats;
+
+static fake_entry_t *find(const char *key) {
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t put(const char *key, const void *value, size_t length) {
+    fake_entry_t *entry = find(key);
+    // NVS 键名最长 15 字符
+    if (strlen(key) > 15 || length > FAKE_NVS_MAX_BLOB) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (entry == NULL) {
+        if (entry_count == FAKE_NVS_MAX_KEYS) {
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        entry = &entries[entry_count++];
+        strcpy(entry->key, key);
+    }
+    memcpy(entry->data, value, length);
+    entry->length = length;
+    return ESP_OK;
+}
+
+static esp_err_t get(const char *key, void *value, size_t length) {
+    fake_entry_t *entry = find(key);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (entry->length != length) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(value, entry->data, length);
+    return ESP_OK;
+}
+
+void fake_nvs_reset(void) {
+    entry_count = 0;
+    fake_nvs_clear_stats();
+}
+
+void fake_nvs_clear_stats(void) {
+    memset(&fake_nvs_stats, 0, sizeof(fake_nvs_stats));
+}
+
+uint8_t *fake_nvs_blob(const char *key, size_t *length) {
+    fake_entry_t *entry = find(key);
+    if (entry == NULL) {
+        return NULL;
+    }
+    *length = entry->length;
+    return entry->data;
+}
+
+void fake_nvs_put_u8(const char *key, uint8_t value) {
+    put(key, &value, 1);
+}
+
+int fake_nvs_key_count(void) {
+    return entry_count;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    entry_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out) {
+    fake_nvs_stats.opens++;
+    *out = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *value) {
+    fake_nvs_stats.reads++;
+    return get(key, value, sizeof(*value));
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+    fake_nvs_stats.writes++;
+    return put(key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value) {
+    fake_nvs_stats.reads++;
+    return get(key, value, sizeof(*value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    fake_nvs_stats.writes++;
+    return put(key, &value, sizeof(value));
+}
+
+// 与 ESP-IDF 一致：value 为 NULL 时只返回长度，缓冲不足时返回 ESP_ERR_NVS_INVALID_LENGTH
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length) {
+    fake_nvs_stats.reads++;
+    fake_entry_t *entry = find(key);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (value == NULL) {
+        *length = entry->length;
+        return ESP_OK;
+    }
+    if (*length < entry->length) {
+        *length = entry->length;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(value, entry->data, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    fake_nvs_stats.writes++;
+    return put(key, value, length);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    fake_nvs_stats.commits++;
+    return ESP_OK;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef HOST_FAKE_NVS_H
+#define HOST_FAKE_NVS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "nvs.h"
+
+// 主机测试用的 NVS 后端：单一命名空间的内存键值表，统计读写与提交次数
+typedef struct {
+    uint32_t reads;     // nvs_get_*
+    uint32_t writes;    // nvs_set_*
+    uint32_t commits;
+    uint32_t opens;
+} fake_nvs_stats_t;
+
+extern fake_nvs_stats_t fake_nvs_stats;
+
+void fake_nvs_reset(void);
+void fake_nvs_clear_stats(void);
+// 直接读写存储内容，不计入统计
+uint8_t *fake_nvs_blob(const char *key, size_t *length);
+void fake_nvs_put_u8(const char *key, uint8_t value);
+int fake_nvs_key_count(void);
+
+#endif
\ No newline at end of file
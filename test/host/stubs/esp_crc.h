@@ -0,0 +1,18 @@
+#ifndef HOST_STUB_ESP_CRC_H
+#define HOST_STUB_ESP_CRC_H
+
+#include <stdint.h>
+
+// 与 ROM 中的 crc32_le 相同：多项式 0xEDB88320，输入输出取反
+static inline uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef HOST_STUB_ESP_LOG_H
+#define HOST_STUB_ESP_LOG_H
+
+// 主机测试不输出日志，参数仍会被求值
+static inline void host_log(const char *tag, const char *format, ...) {
+}
+
+#define ESP_LOGE(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) host_log(tag, __VA_ARGS__)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef HOST_STUB_ESP_TIMER_H
+#define HOST_STUB_ESP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 主机测试用：定时器只记录是否启动，从不触发回调，由测试显式调用 flush
+typedef struct {
+    bool active;
+} host_timer_t;
+typedef host_timer_t *esp_timer_handle_t;
+
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+
+typedef struct {
+    void (*callback)(void *arg);
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+} esp_timer_create_args_t;
+
+static inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    static host_timer_t timers[4];
+    static int count = 0;
+    *out = &timers[count++ % 4];
+    (*out)->active = false;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    timer->active = true;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    timer->active = false;
+    return ESP_OK;
+}
+
+static inline bool esp_timer_is_active(esp_timer_handle_t timer) {
+    return timer->active;
+}
+
+static inline int64_t esp_timer_get_time(void) {
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef HOST_STUB_FREERTOS_H
+#define HOST_STUB_FREERTOS_H
+
+#include <stdint.h>
+
+// 主机测试为单线程，只提供被测代码用到的类型与常量
+typedef int BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE           1
+#define pdFALSE          0
+#define pdPASS           1
+#define portMAX_DELAY    0xFFFFFFFF
+#define tskIDLE_PRIORITY 0
+
+#endif
\ No newline at end of file
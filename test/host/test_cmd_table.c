@@ -0,0 +1,98 @@
+#include "test_main.h"
+#include "cmd_table.h"
+#include "process_commander.h"
+#include "gpio_handle.h"
+
+extern const cmd_handler_t all_handlers[];
+extern const int all_handler_count;
+
+static void test_unknown_opcodes(void) {
+    static const uint8_t unknown[] = { 0x0E, 0x2B, 0x80, 0xF9, 0xFE, 0xFF };
+    for (int i = 0; i < sizeof(unknown); i++) {
+        CHECK(command_lookup(unknown[i]) == NULL);
+        CHECK(command_validate(unknown[i], 0, PROTO_V1_DATA_LEN) == CMD_CHECK_UNKNOWN);
+    }
+}
+
+static void test_every_opcode_fits_v2(void) {
+    // 每个操作码都必须能用 v2 帧发送
+    int defined = 0;
+    for (int op = 0; op < 256; op++) {
+        const cmd_spec_t *spec = command_lookup(op);
+        if (spec == NULL) {
+            continue;
+        }
+        defined++;
+        CHECK(spec->payload_len >= 1);
+        CHECK(spec->payload_len <= PROTO_V2_DATA_LEN);
+    }
+    CHECK(defined == 46);
+}
+
+static void test_gpio_mask(void) {
+    for (int pin = 0; pin < 256; pin++) {
+        cmd_check_t check = command_validate(0x00, pin, PROTO_V1_DATA_LEN);
+        bool is_switch = pin < 64 && (SWITCH_GPIO_MASK & (1ULL << pin));
+        CHECK(check == (is_switch ? CMD_CHECK_OK : CMD_CHECK_BAD_GPIO));
+    }
+    CHECK(command_validate(0x03, GPIO_NUM_9, PROTO_V1_DATA_LEN) == CMD_CHECK_OK);
+    CHECK(command_validate(0x02, GPIO_NUM_9, PROTO_V1_DATA_LEN) == CMD_CHECK_BAD_GPIO);
+    CHECK(command_validate(0x15, GPIO_NUM_11, PROTO_V1_DATA_LEN) == CMD_CHECK_OK);
+    CHECK(command_validate(0x15, GPIO_NUM_34, PROTO_V1_DATA_LEN) == CMD_CHECK_OK);
+    CHECK(command_validate(0x15, GPIO_NUM_45, PROTO_V1_DATA_LEN) == CMD_CHECK_BAD_GPIO);
+    // 无掩码的操作码不检查 cmd
+    CHECK(command_validate(0x05, 0xFD, PROTO_V1_DATA_LEN) == CMD_CHECK_OK);
+}
+
+static void test_payload_len(void) {
+    const cmd_spec_t *ota_data = command_lookup(0x26);
+    CHECK(ota_data != NULL);
+    CHECK(command_validate(0x26, 0, ota_data->payload_len) == CMD_CHECK_OK);
+    CHECK(command_validate(0x26, 0, ota_data->payload_len - 1) == CMD_CHECK_BAD_LENGTH);
+    CHECK(command_validate(0x26, 0, PROTO_V2_DATA_LEN) == CMD_CHECK_OK);
+    CHECK(command_validate(0x1D, 0, 15) == CMD_CHECK_BAD_LENGTH);
+    // GPIO 错误优先于长度错误
+    CHECK(command_validate(0x00, 0, 0) == CMD_CHECK_BAD_GPIO);
+}
+
+static void test_nvs_write_flags(void) {
+    static const uint8_t writers[] = { 0x00, 0x01, 0x05, 0x06, 0x08, 0x0A, 0x0C, 0x10, 0x13, 0x15, 0x1B, 0x1C, 0x21, 0x27 };
+    for (int i = 0; i < sizeof(writers); i++) {
+        CHECK(command_lookup(writers[i])->flags & CMD_FLAG_NVS_WRITE);
+    }
+    CHECK(!(command_lookup(0x1A)->flags & CMD_FLAG_NVS_WRITE));
+}
+
+// 每个操作码都有处理函数，每个处理函数都至少被一个操作码引用
+static void test_handlers(void) {
+    for (int op = 0; op < 256; op++) {
+        const cmd_spec_t *spec = command_lookup(op);
+        if (spec != NULL) {
+            CHECK(spec->handler != NULL);
+        }
+    }
+    for (int i = 0; i < all_handler_count; i++) {
+        int refs = 0;
+        for (int op = 0; op < 256; op++) {
+            const cmd_spec_t *spec = command_lookup(op);
+            if (spec != NULL && spec->handler == all_handlers[i]) {
+                refs++;
+            }
+        }
+        CHECK(refs >= 1);
+    }
+    CHECK(command_lookup(0x00)->handler == command_lookup(0x01)->handler);
+    CHECK(command_lookup(0x19)->handler == cmd_opcode_stats);
+    CHECK(command_lookup(0xFD)->handler == cmd_apply_all);
+}
+
+int main(void) {
+    test_unknown_opcodes();
+    test_every_opcode_fits_v2();
+    test_gpio_mask();
+    test_payload_len();
+    test_nvs_write_flags();
+    test_handlers();
+    printf("test_cmd_table: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
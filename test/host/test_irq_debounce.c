@@ -0,0 +1,161 @@
+#include <string.h>
+#include "test_main.h"
+#include "irq_debounce.h"
+
+#define MS(x) ((int64_t)(x) * 1000)
+
+static edge_ring_t ring;
+static debounce_pin_t pins[2];
+static debounce_pin_t *pin_by_gpio[64];
+
+static void setup(uint8_t window_a, uint8_t window_b) {
+    memset(&ring, 0, sizeof(ring));
+    memset(pins, 0, sizeof(pins));
+    memset(pin_by_gpio, 0, sizeof(pin_by_gpio));
+    debounce_pin_init(&pins[0], 11, 0, window_a);
+    debounce_pin_init(&pins[1], 33, 1, window_b);
+    pin_by_gpio[11] = &pins[0];
+    pin_by_gpio[33] = &pins[1];
+}
+
+static void edge(uint8_t gpio, uint8_t level, int64_t t_us) {
+    if (!edge_ring_push(&ring, gpio, level, (uint32_t)t_us)) {
+        pin_by_gpio[gpio]->stats.dropped++;
+    }
+}
+
+// 机械开关闭合的抖动记录：0→1 之后 3 ms 内抖动 5 次，最终稳定为 1
+static const struct { int64_t t_us; uint8_t level; } bounce_trace[] = {
+    { 100000, 1 }, { 100180, 0 }, { 100420, 1 }, { 101050, 0 }, { 101700, 1 }, { 102950, 0 }, { 103100, 1 },
+};
+#define BOUNCE_COUNT (sizeof(bounce_trace) / sizeof(bounce_trace[0]))
+
+static void test_bounce_burst(void) {
+    uint8_t level = 0xFF;
+    setup(DEBOUNCE_DEFAULT_MS, DEBOUNCE_DEFAULT_MS);
+    for (int i = 0; i < BOUNCE_COUNT; i++) {
+        edge(11, bounce_trace[i].level, bounce_trace[i].t_us);
+    }
+    int64_t last = bounce_trace[BOUNCE_COUNT - 1].t_us;
+    edge_ring_drain(&ring, pin_by_gpio, last + 50);
+
+    // 窗口从最后一个边沿开始计时
+    CHECK(debounce_remaining_us(&pins[0], last) == MS(20));
+    CHECK(!debounce_settle(&pins[0], last + MS(20) - 1, &level));
+    CHECK(debounce_settle(&pins[0], last + MS(20), &level));
+    CHECK(level == 1);
+    CHECK(pins[0].stats.events == 1);
+    CHECK(pins[0].stats.coalesced == BOUNCE_COUNT - 1);
+    CHECK(pins[0].stats.filtered == 0);
+    CHECK(debounce_remaining_us(&pins[0], last + MS(30)) == -1);
+    CHECK(!debounce_settle(&pins[0], last + MS(40), &level));
+    CHECK(pins[0].stats.events == 1);
+}
+
+// 抖动后回到原电平：不分发事件，计为 filtered
+static void test_bounce_back(void) {
+    uint8_t level;
+    setup(DEBOUNCE_DEFAULT_MS, DEBOUNCE_DEFAULT_MS);
+    edge(11, 1, MS(5));
+    edge(11, 0, MS(6));
+    edge_ring_drain(&ring, pin_by_gpio, MS(7));
+    CHECK(!debounce_settle(&pins[0], MS(26), &level));
+    CHECK(pins[0].stats.events == 0);
+    CHECK(pins[0].stats.filtered == 1);
+    CHECK(pins[0].stats.coalesced == 1);
+    CHECK(!pins[0].waiting);
+}
+
+// 分次取出时，窗口内后到的边沿重新开始计时
+static void test_split_drain(void) {
+    uint8_t level;
+    setup(DEBOUNCE_DEFAULT_MS, DEBOUNCE_DEFAULT_MS);
+    edge(11, 1, MS(0));
+    edge_ring_drain(&ring, pin_by_gpio, MS(1));
+    CHECK(debounce_remaining_us(&pins[0], MS(1)) == MS(19));
+    edge(11, 0, MS(10));
+    edge(11, 1, MS(15));
+    edge_ring_drain(&ring, pin_by_gpio, MS(16));
+    CHECK(!debounce_settle(&pins[0], MS(20), &level));
+    CHECK(debounce_remaining_us(&pins[0], MS(20)) == MS(15));
+    CHECK(debounce_settle(&pins[0], MS(35), &level));
+    CHECK(level == 1);
+    CHECK(pins[0].stats.coalesced == 2);
+}
+
+// 自定义 debounce_<gpio> 窗口按引脚独立生效，0 表示立即分发
+static void test_custom_windows(void) {
+    uint8_t level;
+    setup(50, 0);
+    edge(11, 1, MS(100));
+    edge(33, 0, MS(100));
+    edge_ring_drain(&ring, pin_by_gpio, MS(100));
+    CHECK(debounce_remaining_us(&pins[1], MS(100)) == 0);
+    CHECK(debounce_settle(&pins[1], MS(100), &level));
+    CHECK(level == 0);
+    CHECK(!debounce_settle(&pins[0], MS(120), &level));
+    CHECK(!debounce_settle(&pins[0], MS(149), &level));
+    CHECK(debounce_settle(&pins[0], MS(150), &level));
+    CHECK(level == 1);
+
+    // 运行中修改窗口对等待中的引脚立即生效
+    edge(11, 0, MS(200));
+    edge_ring_drain(&ring, pin_by_gpio, MS(200));
+    debounce_pin_set_window(&pins[0], 5);
+    CHECK(debounce_remaining_us(&pins[0], MS(201)) == MS(4));
+    CHECK(debounce_settle(&pins[0], MS(205), &level));
+    CHECK(level == 0);
+    CHECK(pins[0].stats.events == 2);
+    CHECK(pins[1].stats.events == 1);
+}
+
+// 缓冲满时丢弃新边沿并计数，取出后可继续写入
+static void test_overflow(void) {
+    uint8_t level;
+    setup(DEBOUNCE_DEFAULT_MS, DEBOUNCE_DEFAULT_MS);
+    for (int i = 0; i < EDGE_RING_SIZE + 5; i++) {
+        edge(i % 2 ? 33 : 11, (i / 2) % 2, MS(1) + i);
+    }
+    CHECK(pins[0].stats.dropped + pins[1].stats.dropped == 5);
+    CHECK(pins[0].stats.dropped == 3);
+    CHECK(pins[1].stats.dropped == 2);
+    edge_ring_drain(&ring, pin_by_gpio, MS(2));
+    CHECK(pins[0].stats.coalesced == EDGE_RING_SIZE / 2 - 1);
+    CHECK(pins[1].stats.coalesced == EDGE_RING_SIZE / 2 - 1);
+    CHECK(ring.head == ring.tail);
+
+    edge(11, 1, MS(3));
+    CHECK(pins[0].stats.dropped == 3);
+    edge_ring_drain(&ring, pin_by_gpio, MS(3));
+    CHECK(debounce_settle(&pins[0], MS(23), &level));
+    CHECK(level == 1);
+}
+
+// 下标回绕与 32 位时间戳回绕
+static void test_wraparound(void) {
+    uint8_t level;
+    setup(DEBOUNCE_DEFAULT_MS, DEBOUNCE_DEFAULT_MS);
+    ring.head = ring.tail = UINT32_MAX - 2;
+    int64_t base = ((int64_t)1 << 32) - MS(1);
+    for (int i = 0; i < 6; i++) {
+        edge(11, (i + 1) % 2, base + i * 400);
+    }
+    CHECK(pins[0].stats.dropped == 0);
+    edge_ring_drain(&ring, pin_by_gpio, base + MS(3));
+    CHECK(ring.tail == 3);
+    CHECK(pins[0].last_edge_us == base + 5 * 400);
+    CHECK(pins[0].latest_level == 0);
+    CHECK(!debounce_settle(&pins[0], base + 5 * 400 + MS(20), &level));
+    CHECK(pins[0].stats.filtered == 1);
+}
+
+int main(void) {
+    test_bounce_burst();
+    test_bounce_back();
+    test_split_drain();
+    test_custom_windows();
+    test_overflow();
+    test_wraparound();
+    printf("test_irq_debounce: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef HOST_TEST_MAIN_H
+#define HOST_TEST_MAIN_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(expr) do { \
+        if (!(expr)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#endif
\ No newline at end of file
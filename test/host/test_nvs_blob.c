@@ -0,0 +1,161 @@
+#include <string.h>
+#include "test_main.h"
+#include "fake_nvs.h"
+#include "esp_crc.h"
+#include "nvs_handle.h"
+
+// 与 nvs_handle.c 中的布局一致：9 个开关引脚 ×2、6 个中断引脚、3 个槽位、9 个全局项
+#define KEY_COUNT     (9 * 2 + 6 + 3 + 9)
+#define PAYLOAD_LEN   (KEY_COUNT + (KEY_COUNT + 7) / 8)
+#define HEADER_LEN    12
+#define IDX_GPIO_34   3
+#define IDX_EXT_33    (9 + 2)
+#define IDX_DEB_11    (18 + 1)
+#define IDX_HID_PROF  (KEY_COUNT - 1)
+
+static uint16_t get_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t *config_blob(void) {
+    size_t len = 0;
+    const uint8_t *blob = fake_nvs_blob("config", &len);
+    CHECK(blob != NULL);
+    CHECK(len >= HEADER_LEN + PAYLOAD_LEN);
+    return blob;
+}
+
+static bool blob_present(const uint8_t *blob, int index) {
+    return (blob[HEADER_LEN + KEY_COUNT + index / 8] >> (index % 8)) & 0x01;
+}
+
+static void put_legacy_keys(void) {
+    fake_nvs_put_u8("gpio_34", 1);
+    fake_nvs_put_u8("ext_gpio_33", 2);
+    fake_nvs_put_u8("debounce_11", 50);
+    fake_nvs_put_u8("spin_prio_45", 0);
+    // "enclosure_mode_0" 超过 15 字符，旧固件写入时被 16 字节缓冲截断
+    fake_nvs_put_u8("enclosure_mode_", 1);
+    fake_nvs_put_u8("hid_prof_0", 1);
+}
+
+static void check_legacy_values(void) {
+    const enclosure_config_t *config = get_config();
+    CHECK(config->gpio[34].present && config->gpio[34].value == 1);
+    CHECK(!config->gpio[33].present && config->gpio[33].value == 0);
+    CHECK(config->ext_gpio[33].present && config->ext_gpio[33].value == 2);
+    CHECK(config->debounce[11].present && config->debounce[11].value == 50);
+    CHECK(config->spin_prio[45].present && config->spin_prio[45].value == 0);
+    CHECK(config->enclosure_mode.present && config->enclosure_mode.value == 1);
+    CHECK(config->hid_prof.present && config->hid_prof.value == 1);
+    CHECK(!config->sata_onpower.present);
+}
+
+// 旧版逐键布局迁移为 blob，旧键保留
+static void test_legacy_migration(void) {
+    fake_nvs_reset();
+    put_legacy_keys();
+    int legacy_keys = fake_nvs_key_count();
+    init_nvs();
+    check_legacy_values();
+    CHECK(fake_nvs_stats.commits == 1);
+    CHECK(fake_nvs_key_count() == legacy_keys + 1);
+
+    uint8_t value;
+    CHECK(read_nvs_state(0x00, "hid_prof", &value) == ESP_OK && value == 1);
+    CHECK(read_nvs_state(0x00, "sata_onpower", &value) == ESP_ERR_NVS_NOT_FOUND && value == 0);
+}
+
+// blob 头部、紧凑排列的值、存在位图与 CRC
+static void test_blob_pack(void) {
+    const uint8_t *blob = config_blob();
+    size_t len;
+    fake_nvs_blob("config", &len);
+    CHECK(len == ((HEADER_LEN + PAYLOAD_LEN + 3) & ~3));
+    CHECK(get_u16(blob) == 0x5243);
+    CHECK(blob[2] == 2);
+    CHECK(get_u16(blob + 4) == PAYLOAD_LEN);
+    CHECK(get_u32(blob + 8) == esp_crc32_le(0, blob + HEADER_LEN, PAYLOAD_LEN));
+
+    const uint8_t *value = blob + HEADER_LEN;
+    CHECK(value[IDX_GPIO_34] == 1 && blob_present(blob, IDX_GPIO_34));
+    CHECK(value[IDX_EXT_33] == 2 && blob_present(blob, IDX_EXT_33));
+    CHECK(value[IDX_DEB_11] == 50 && blob_present(blob, IDX_DEB_11));
+    CHECK(value[IDX_HID_PROF] == 1 && blob_present(blob, IDX_HID_PROF));
+    int present = 0;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        present += blob_present(blob, i);
+    }
+    CHECK(present == 6);
+}
+
+// 重启后只读 blob 与磨损计数，不再逐键读取
+static void test_reload_from_blob(void) {
+    fake_nvs_clear_stats();
+    init_nvs();
+    check_legacy_values();
+    CHECK(fake_nvs_stats.reads == 3);
+    CHECK(fake_nvs_stats.writes == 0);
+    CHECK(fake_nvs_stats.commits == 0);
+}
+
+// hid_prof 已被镜像：写入进入 blob，不再产生单独的 "hid_prof_0" 键
+static void test_hid_prof_mirrored(void) {
+    int keys = fake_nvs_key_count();
+    fake_nvs_clear_stats();
+    save_state(0x00, 0, "hid_prof");
+    CHECK(fake_nvs_stats.writes == 0);
+    nvs_flush_state(false);
+    CHECK(fake_nvs_stats.writes == 1);
+    CHECK(fake_nvs_stats.commits == 1);
+    CHECK(fake_nvs_key_count() == keys);
+    const uint8_t *blob = config_blob();
+    CHECK(blob[HEADER_LEN + IDX_HID_PROF] == 0 && blob_present(blob, IDX_HID_PROF));
+    CHECK(get_u32(blob + 8) == esp_crc32_le(0, blob + HEADER_LEN, PAYLOAD_LEN));
+    CHECK(get_config()->hid_prof.value == 0);
+}
+
+// CRC 不符时丢弃 blob，从旧键重新迁移并改写为有效的 blob
+static void test_crc_mismatch(void) {
+    size_t len;
+    uint8_t *blob = fake_nvs_blob("config", &len);
+    blob[HEADER_LEN + IDX_GPIO_34] ^= 0x01;
+    fake_nvs_clear_stats();
+    init_nvs();
+    check_legacy_values();
+    CHECK(fake_nvs_stats.commits == 1);
+    blob = fake_nvs_blob("config", &len);
+    CHECK(blob[HEADER_LEN + IDX_GPIO_34] == 1);
+    CHECK(get_u32(blob + 8) == esp_crc32_le(0, blob + HEADER_LEN, PAYLOAD_LEN));
+}
+
+// 键表不同(payload 长度不符)或 magic 错误的 blob 同样回退到旧键
+static void test_bad_header(void) {
+    size_t len;
+    uint8_t *blob = fake_nvs_blob("config", &len);
+    blob[4]--;
+    init_nvs();
+    check_legacy_values();
+    CHECK(get_u16(config_blob() + 4) == PAYLOAD_LEN);
+
+    blob = fake_nvs_blob("config", &len);
+    blob[0] = 0;
+    init_nvs();
+    check_legacy_values();
+    CHECK(get_u16(config_blob()) == 0x5243);
+}
+
+int main(void) {
+    test_legacy_migration();
+    test_blob_pack();
+    test_reload_from_blob();
+    test_hid_prof_mirrored();
+    test_crc_mismatch();
+    test_bad_header();
+    printf("test_nvs_blob: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
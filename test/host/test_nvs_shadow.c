@@ -0,0 +1,131 @@
+#include <string.h>
+#include "test_main.h"
+#include "fake_nvs.h"
+#include "nvs_handle.h"
+
+// 旧版每次 get_nvs_state()/save_state() 都 nvs_open + nvs_get/set_u8 (+ nvs_commit)，
+// 这里用假 NVS 统计镜像化之后每个查询命令实际触发的 NVS 调用
+typedef struct {
+    const char *name;
+    int legacy_calls;    // 旧版对 NVS 的调用次数(open + get)
+} command_cost_t;
+
+static uint32_t nvs_calls(void) {
+    return fake_nvs_stats.opens + fake_nvs_stats.reads + fake_nvs_stats.writes + fake_nvs_stats.commits;
+}
+
+static void report(const command_cost_t *cost, uint32_t calls) {
+    printf("  %-28s legacy %2d NVS call/s, shadow %2u\n", cost->name, cost->legacy_calls, calls);
+}
+
+static void setup(void) {
+    fake_nvs_reset();
+    fake_nvs_put_u8("gpio_34", 1);
+    fake_nvs_put_u8("gpio_38", 1);
+    fake_nvs_put_u8("ext_gpio_34", 0);
+    fake_nvs_put_u8("sata_onpower_0", 3);
+    fake_nvs_put_u8("susp_en_0", 1);
+    init_nvs();
+}
+
+// 查询命令与 restore_state() 读取的全是镜像，不访问 NVS
+static void test_queries_served_from_ram(void) {
+    static const uint8_t switch_pins[] = { 14, 21, 33, 34, 35, 36, 37, 38, 45 };
+    static const command_cost_t costs[] = {
+        { "0x02 gpio saved (9 pins)", 9 * 2 },
+        { "0x07 ext_gpio (9 pins)", 9 * 2 },
+        { "0x09/0x0B/0x0D scalars", 3 * 2 },
+        { "0x0F power summary", 4 * 2 },
+        { "restore_state()", (7 + 1 + 1) * 2 },
+    };
+    uint32_t calls;
+
+    fake_nvs_clear_stats();
+    for (int i = 0; i < sizeof(switch_pins); i++) {
+        get_nvs_state(switch_pins[i], "gpio");
+    }
+    calls = nvs_calls();
+    report(&costs[0], calls);
+    CHECK(calls == 0);
+
+    fake_nvs_clear_stats();
+    for (int i = 0; i < sizeof(switch_pins); i++) {
+        get_nvs_state(switch_pins[i], "ext_gpio");
+    }
+    calls = nvs_calls();
+    report(&costs[1], calls);
+    CHECK(calls == 0);
+
+    fake_nvs_clear_stats();
+    CHECK(get_nvs_state(0x00, "sata_onpower") == 3);
+    CHECK(get_nvs_state(0x00, "susp_en") == 1);
+    CHECK(get_nvs_state(0x00, "ususp_en") == 0);
+    calls = nvs_calls();
+    report(&costs[2], calls);
+    CHECK(calls == 0);
+
+    fake_nvs_clear_stats();
+    enclosure_mode_selected();
+    get_nvs_state(0x00, "ext_restart");
+    get_nvs_state(0x00, "sata_onpower");
+    get_nvs_state(0x00, "susp_en");
+    calls = fake_nvs_stats.opens + fake_nvs_stats.reads;
+    report(&costs[3], calls);
+    CHECK(calls == 0);
+
+    // restore_state() 通过 get_config() 构建计划：只读镜像
+    fake_nvs_clear_stats();
+    const enclosure_config_t *config = get_config();
+    CHECK(config->gpio[34].present && config->gpio[34].value == 1);
+    CHECK(config->ext_gpio[34].present && config->ext_gpio[34].value == 0);
+    CHECK(config->sata_onpower.value == 3);
+    calls = nvs_calls();
+    report(&costs[4], calls);
+    CHECK(calls == 0);
+}
+
+// 写入先进入镜像并合并，flush 时整个 blob 只写一次、提交一次；值未变化的写入被跳过
+static void test_writes_coalesced(void) {
+    static const uint8_t pins[] = { 33, 34, 35, 38 };
+    static const uint8_t values[] = { 1, 0, 1, 0 };
+
+    nvs_flush_state(false);
+    fake_nvs_clear_stats();
+    save_state_batch(pins, values, sizeof(pins), "gpio");
+    save_state(0x00, 5, "sata_onpower");
+    CHECK(nvs_calls() == 0);
+    CHECK(get_nvs_state(34, "gpio") == 0);
+    CHECK(get_nvs_state(0x00, "sata_onpower") == 5);
+
+    nvs_flush_state(false);
+    printf("  %-28s legacy %2d NVS call/s, shadow %2u\n", "5 saves + flush", 5 * 4, nvs_calls());
+    CHECK(fake_nvs_stats.writes == 1);
+    CHECK(fake_nvs_stats.commits == 1);
+
+    fake_nvs_clear_stats();
+    save_state(0x00, 5, "sata_onpower");
+    nvs_flush_state(false);
+    CHECK(nvs_calls() == 0);
+
+    uint32_t count, commits;
+    CHECK(nvs_wear_count("gpio_34", &count, &commits) == ESP_OK && count == 1);
+    CHECK(nvs_wear_count("sata_onpower_0", &count, &commits) == ESP_OK && count == 1);
+}
+
+// 未镜像的键仍直接访问 NVS
+static void test_unmirrored_key(void) {
+    uint8_t value;
+    fake_nvs_put_u8("gpio_9", 7);
+    fake_nvs_clear_stats();
+    CHECK(read_nvs_state(9, "gpio", &value) == ESP_OK && value == 7);
+    CHECK(fake_nvs_stats.opens == 1 && fake_nvs_stats.reads == 1);
+}
+
+int main(void) {
+    setup();
+    test_queries_served_from_ram();
+    test_writes_coalesced();
+    test_unmirrored_key();
+    printf("test_nvs_shadow: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
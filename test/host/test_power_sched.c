@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_main.h"
+#include "power_sched.h"
+
+#define MS(x) ((int64_t)(x) * 1000)
+
+typedef struct {
+    power_sched_slot_t slots[POWER_SEQ_SLOT_COUNT];
+    power_seq_policy_t policy;
+    int64_t last_enable_us;
+    int64_t enabled_at[POWER_SEQ_SLOT_COUNT];
+} sim_t;
+
+static int active_at(const sim_t *sim, int64_t now) {
+    int active = 0;
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        if (sim->slots[i].state == POWER_SLOT_ON && sim->slots[i].ready_us + (int64_t)sim->policy.spin_100ms * 100000 > now) {
+            active++;
+        }
+    }
+    return active;
+}
+
+// 与 schedule_locked() 相同：反复判定并上电直到返回 -1，同时检查每次上电都满足策略
+static int64_t run_schedule(sim_t *sim, int64_t now) {
+    int64_t next_us;
+    int pick;
+    while ((pick = power_sched_pick(sim->slots, &sim->policy, sim->last_enable_us, now, &next_us)) >= 0) {
+        CHECK(sim->slots[pick].state == POWER_SLOT_QUEUED);
+        CHECK(now - sim->last_enable_us >= (int64_t)sim->policy.gap_10ms * 10000);
+        CHECK(sim->policy.max_active == 0 || active_at(sim, now) < sim->policy.max_active);
+        for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+            // 队列中不存在优先级更高的槽位
+            if (sim->slots[i].state == POWER_SLOT_QUEUED) {
+                CHECK(sim->policy.priority[i] >= sim->policy.priority[pick]);
+            }
+        }
+        sim->slots[pick].state = POWER_SLOT_ON;
+        sim->slots[pick].ready_us = now;
+        sim->last_enable_us = now;
+        sim->enabled_at[pick] = now;
+    }
+    // 返回 -1 时不得遗漏可以上电的槽位
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        CHECK(sim->slots[i].state != POWER_SLOT_WAITING || sim->slots[i].deadline_us > now);
+        if (sim->slots[i].state == POWER_SLOT_QUEUED) {
+            CHECK(now - sim->last_enable_us < (int64_t)sim->policy.gap_10ms * 10000 ||
+                  (sim->policy.max_active != 0 && active_at(sim, now) >= sim->policy.max_active));
+            CHECK(next_us > now && next_us != INT64_MAX);
+        }
+    }
+    return next_us;
+}
+
+static void request(sim_t *sim, int slot, int64_t now, uint32_t delay_ms) {
+    sim->slots[slot].state = POWER_SLOT_WAITING;
+    sim->slots[slot].deadline_us = now + MS(delay_ms);
+}
+
+static void init_sim(sim_t *sim, uint8_t max_active, uint8_t gap_10ms, uint8_t spin_100ms, const uint8_t prio[POWER_SEQ_SLOT_COUNT]) {
+    memset(sim, 0, sizeof(*sim));
+    sim->policy.max_active = max_active;
+    sim->policy.gap_10ms = gap_10ms;
+    sim->policy.spin_100ms = spin_100ms;
+    memcpy(sim->policy.priority, prio, POWER_SEQ_SLOT_COUNT);
+    sim->last_enable_us = INT64_MIN / 2;
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        sim->enabled_at[i] = -1;
+    }
+}
+
+// 只在 next_us 唤醒，模拟 seq_timer；返回时全部槽位应已上电
+static void run_until_idle(sim_t *sim, int64_t now) {
+    for (int guard = 0; guard < 100; guard++) {
+        int64_t next_us = run_schedule(sim, now);
+        if (next_us == INT64_MAX) {
+            break;
+        }
+        CHECK(next_us > now);
+        now = next_us;
+    }
+}
+
+static void test_simultaneous_requests(void) {
+    static const uint8_t prio[POWER_SEQ_SLOT_COUNT] = { 2, 0, 1 };
+    sim_t sim;
+    init_sim(&sim, 1, 0, 30, prio);
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        request(&sim, i, MS(1000), 0);
+    }
+    run_until_idle(&sim, MS(1000));
+    // 一次只起转一个，按优先级 SATA2 → NVMe → SATA1，间隔一个起转窗口
+    CHECK(sim.enabled_at[1] == MS(1000));
+    CHECK(sim.enabled_at[2] == MS(4000));
+    CHECK(sim.enabled_at[0] == MS(7000));
+}
+
+static void test_gap(void) {
+    static const uint8_t prio[POWER_SEQ_SLOT_COUNT] = { 0, 1, 2 };
+    sim_t sim;
+    init_sim(&sim, 0, 50, 30, prio);
+    for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+        request(&sim, i, 0, 0);
+    }
+    run_until_idle(&sim, 0);
+    CHECK(sim.enabled_at[0] == 0);
+    CHECK(sim.enabled_at[1] == MS(500));
+    CHECK(sim.enabled_at[2] == MS(1000));
+}
+
+static void test_unlimited(void) {
+    static const uint8_t prio[POWER_SEQ_SLOT_COUNT] = { 0, 0, 0 };
+    sim_t sim;
+    init_sim(&sim, 0, 0, 0, prio);
+    request(&sim, 0, 0, 0);
+    request(&sim, 1, 0, 3000);
+    request(&sim, 2, 0, 0);
+    run_until_idle(&sim, 0);
+    CHECK(sim.enabled_at[0] == 0);
+    CHECK(sim.enabled_at[2] == 0);
+    CHECK(sim.enabled_at[1] == MS(3000));
+}
+
+// 随机策略与请求：任何时刻都不超过并发上限与间隔，且所有请求最终都会上电
+static void test_random(void) {
+    srand(1);
+    for (int round = 0; round < 2000; round++) {
+        uint8_t prio[POWER_SEQ_SLOT_COUNT];
+        for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+            prio[i] = rand() % 4;
+        }
+        sim_t sim;
+        init_sim(&sim, rand() % 4, rand() % 40, rand() % 40, prio);
+        int64_t now = 0;
+        for (int step = 0; step < 12; step++) {
+            int slot = rand() % POWER_SEQ_SLOT_COUNT;
+            if (sim.slots[slot].state == POWER_SLOT_OFF) {
+                request(&sim, slot, now, rand() % 3 ? 0 : rand() % 5000);
+            } else if (rand() % 4 == 0) {
+                sim.slots[slot].state = POWER_SLOT_OFF;
+            }
+            int64_t next_us = run_schedule(&sim, now);
+            int64_t advance = MS(rand() % 2000);
+            now = (next_us != INT64_MAX && next_us < now + advance) ? next_us : now + advance;
+        }
+        run_until_idle(&sim, now);
+        for (int i = 0; i < POWER_SEQ_SLOT_COUNT; i++) {
+            CHECK(sim.slots[i].state == POWER_SLOT_OFF || sim.slots[i].state == POWER_SLOT_ON);
+        }
+    }
+}
+
+int main(void) {
+    test_simultaneous_requests();
+    test_gap();
+    test_unlimited();
+    test_random();
+    printf("test_power_sched: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
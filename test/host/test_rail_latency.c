@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_main.h"
+#include "power_sched.h"
+
+static int bucket_of(uint32_t us) {
+    rail_latency_t lat;
+    memset(&lat, 0, sizeof(lat));
+    rail_latency_record(&lat, us);
+    for (int i = 0; i < RAIL_LAT_BUCKETS; i++) {
+        if (lat.buckets[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 第 i 桶为 [64 << (i - 1), 64 << i)，第 0 桶从 0 开始，最后一桶不设上限
+static void test_bucket_bounds(void) {
+    CHECK(bucket_of(0) == 0);
+    CHECK(bucket_of(63) == 0);
+    CHECK(bucket_of(64) == 1);
+    CHECK(bucket_of(127) == 1);
+    CHECK(bucket_of(128) == 2);
+    for (int i = 1; i < RAIL_LAT_BUCKETS - 1; i++) {
+        CHECK(bucket_of((64u << i) - 1) == i);
+        CHECK(bucket_of(64u << i) == i + 1);
+    }
+    CHECK(bucket_of(UINT32_MAX) == RAIL_LAT_BUCKETS - 1);
+}
+
+// 合成的边沿轨迹：ISR 时间戳与 GPIO 写入时间，延迟 = 写入 - 边沿
+static void test_edge_trace(void) {
+    static const struct { int64_t edge_us, write_us; } trace[] = {
+        { 1000, 1040 }, { 5000, 5090 }, { 9000, 9100 }, { 12000, 12100 }, { 20000, 25000 },
+    };
+    rail_latency_t lat;
+    memset(&lat, 0, sizeof(lat));
+    for (int i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        rail_latency_record(&lat, (uint32_t)(trace[i].write_us - trace[i].edge_us));
+    }
+    CHECK(lat.count == 5);
+    CHECK(lat.min_us == 40);
+    CHECK(lat.max_us == 5000);
+    CHECK(lat.buckets[0] == 1);
+    CHECK(lat.buckets[1] == 3);
+    CHECK(lat.buckets[7] == 1);
+    // 返回所在桶的上限
+    CHECK(rail_latency_percentile(&lat, 200) == 64);
+    CHECK(rail_latency_percentile(&lat, 500) == 128);
+    CHECK(rail_latency_percentile(&lat, 800) == 128);
+    CHECK(rail_latency_percentile(&lat, 990) == 5000);
+    CHECK(rail_latency_percentile(&lat, 1000) == 5000);
+}
+
+static void test_empty_and_single(void) {
+    rail_latency_t lat;
+    memset(&lat, 0, sizeof(lat));
+    CHECK(rail_latency_percentile(&lat, 990) == 0);
+    rail_latency_record(&lat, 300);
+    CHECK(lat.min_us == 300 && lat.max_us == 300);
+    // 桶上限 512 大于唯一样本时以 max 为准
+    CHECK(rail_latency_percentile(&lat, 10) == 300);
+    CHECK(rail_latency_percentile(&lat, 990) == 300);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// 随机样本：估算值不小于精确百分位，且不超过其所在桶的上限(精确值的 2 倍或 64us)与 max
+static void test_percentile_bounds(void) {
+    static uint32_t samples[1000];
+    static const uint32_t permilles[] = { 1, 100, 500, 900, 990, 999, 1000 };
+    srand(7);
+    for (int round = 0; round < 200; round++) {
+        rail_latency_t lat;
+        memset(&lat, 0, sizeof(lat));
+        int n = 1 + rand() % 1000;
+        for (int i = 0; i < n; i++) {
+            samples[i] = (uint32_t)rand() % (1u << (rand() % 24));
+            rail_latency_record(&lat, samples[i]);
+        }
+        qsort(samples, n, sizeof(samples[0]), compare_u32);
+        CHECK(lat.count == n);
+        CHECK(lat.min_us == samples[0]);
+        CHECK(lat.max_us == samples[n - 1]);
+        for (int p = 0; p < sizeof(permilles) / sizeof(permilles[0]); p++) {
+            int k = (int)(((uint64_t)n * permilles[p] + 999) / 1000);
+            uint32_t exact = samples[k - 1];
+            uint32_t est = rail_latency_percentile(&lat, permilles[p]);
+            CHECK(est >= exact);
+            CHECK(est <= lat.max_us);
+            CHECK(est <= (exact < 64 ? 64 : 2 * exact) || bucket_of(exact) == RAIL_LAT_BUCKETS - 1);
+        }
+    }
+}
+
+int main(void) {
+    test_bucket_bounds();
+    test_edge_trace();
+    test_empty_and_single();
+    test_percentile_bounds();
+    printf("test_rail_latency: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include <string.h>
+#include "test_main.h"
+#include "restore_plan.h"
+#include "gpio_handle.h"
+
+// 旧版 restore_state() 对每个引脚的一次 power_seq_request()/save_state() 调用
+typedef struct {
+    uint8_t gpio_num;
+    uint8_t level;
+    uint32_t delay_ms;
+    bool save_default;
+} pin_action_t;
+
+// 参照实现：旧版 restore_state() 依次调用 (ext_)restore_gpio_state() 的效果
+static int reference_restore(const enclosure_config_t *config, bool ext_power, pin_action_t *out) {
+    static const uint8_t order[] = { 33, 34, 35, 38, 45, 36, 37 };
+    int count = 0;
+    for (int i = 0; i < sizeof(order); i++) {
+        uint8_t pin = order[i];
+        bool use_ext = ext_power && pin != 36 && pin != 37;
+        const config_entry_t *entry = use_ext ? &config->ext_gpio[pin] : &config->gpio[pin];
+        pin_action_t *action = &out[count++];
+        action->gpio_num = pin;
+        if (entry->present) {
+            action->level = entry->value;
+            action->delay_ms = (entry->value == 1 && (pin == 0x22 || pin == 0x26)) ? config->sata_onpower.value * 1000 : 0;
+            action->save_default = false;
+        } else {
+            action->level = 0;
+            action->delay_ms = 0;
+            action->save_default = true;
+        }
+    }
+    return count;
+}
+
+static void set_entry(config_entry_t *entry, int state) {
+    // state: 0 未保存, 1 保存为 0, 2 保存为 1, 3 保存为 2
+    entry->present = state != 0;
+    entry->value = state == 0 ? 0 : state - 1;
+}
+
+static void check_plan(const enclosure_config_t *config, bool ext_power) {
+    pin_action_t expected[RESTORE_GPIO_COUNT];
+    restore_plan_t plan;
+    int count = reference_restore(config, ext_power, expected);
+    int step = 0;
+
+    restore_plan_build(&plan, config, ext_power);
+    CHECK(count == RESTORE_GPIO_COUNT);
+    CHECK((plan.set_mask & plan.clear_mask) == 0);
+    CHECK((plan.set_mask & POWER_SEQ_SLOT_MASK) == 0);
+
+    for (int i = 0; i < count; i++) {
+        const pin_action_t *action = &expected[i];
+        uint64_t bit = 1ULL << action->gpio_num;
+        bool slot = POWER_SEQ_SLOT_MASK & bit;
+        CHECK(((plan.missing_mask & bit) != 0) == action->save_default);
+        if (action->level == 0) {
+            CHECK(plan.clear_mask & bit);
+            CHECK(!(plan.set_mask & bit));
+        } else if (slot) {
+            // 槽位上电保持旧版的调用顺序与等待时间
+            CHECK(step < plan.step_count);
+            CHECK(plan.steps[step].gpio_num == action->gpio_num);
+            CHECK(plan.steps[step].delay_ms == action->delay_ms);
+            step++;
+        } else {
+            CHECK(plan.set_mask & bit);
+            CHECK(!(plan.clear_mask & bit));
+        }
+    }
+    CHECK(step == plan.step_count);
+    CHECK(((plan.set_mask | plan.clear_mask) & ~SWITCH_GPIO_MASK) == 0);
+}
+
+static void test_all_states(bool ext_power, uint8_t sata_onpower) {
+    static const uint8_t pins[] = { 33, 34, 35, 38, 45, 36, 37 };
+    enclosure_config_t config;
+    int combos = 1;
+    for (int i = 0; i < sizeof(pins); i++) {
+        combos *= 4;
+    }
+
+    for (int combo = 0; combo < combos; combo++) {
+        memset(&config, 0, sizeof(config));
+        config.sata_onpower.present = 1;
+        config.sata_onpower.value = sata_onpower;
+        int c = combo;
+        for (int i = 0; i < sizeof(pins); i++) {
+            // 当前模式使用的表逐一穷举，另一张表取相反的值，确保不会被误读
+            bool use_ext = ext_power && i < EXT_RESTORE_GPIO_COUNT;
+            set_entry(use_ext ? &config.ext_gpio[pins[i]] : &config.gpio[pins[i]], c % 4);
+            if (i < EXT_RESTORE_GPIO_COUNT) {
+                set_entry(use_ext ? &config.gpio[pins[i]] : &config.ext_gpio[pins[i]], 3 - c % 4);
+            }
+            c /= 4;
+        }
+        check_plan(&config, ext_power);
+    }
+}
+
+static void test_restore_order(void) {
+    static const uint8_t order[] = { 33, 34, 35, 38, 45, 36, 37 };
+    CHECK(memcmp(restore_gpios, order, sizeof(order)) == 0);
+}
+
+int main(void) {
+    test_restore_order();
+    test_all_states(false, 0);
+    test_all_states(false, 5);
+    test_all_states(true, 0);
+    test_all_states(true, 5);
+    printf("test_restore_plan: %d failure/s\n", test_failures);
+    return test_failures != 0;
+}
\ No newline at end of file